@@ -0,0 +1,161 @@
+#!/bin/sh
+# Benchmark suite of exampleB4d (the "bench" target of the CMake build)
+#
+# Each workload runs with fixed seeds for 1, 2, 4 and N threads (N = the
+# number of cores); the events/s, primaries/s, steps/s of the measured run,
+# the peak RSS and the startup time (until the first event) are written in
+# a CSV file. The script fails when a run fails or does not report its
+# rates. With a baseline file (a previous output), the results are
+# compared and the script fails when one of them is worse by more than
+# the threshold (lower throughput, or higher memory or startup time), or
+# when a result of the baseline is missing.
+#
+# usage: ./bench.sh [-o output.csv] [-b baseline.csv] [-t threshold(%)]
+#                   [-n "threadCounts"]
+# It needs a multi-threaded build.
+#
+output=B4_bench.csv
+baseline=
+threshold=10
+threadCounts=
+while getopts "o:b:t:n:" option; do
+  case $option in
+    o) output=$OPTARG ;;
+    b) baseline=$OPTARG ;;
+    t) threshold=$OPTARG ;;
+    n) threadCounts=$OPTARG ;;
+    *) sed -n '13,15p' "$0" >&2; exit 2 ;;
+  esac
+done
+
+nofCores=$(nproc 2>/dev/null || echo 1)
+if [ -z "$threadCounts" ]; then
+  threadCounts=$(for n in 1 2 4 $nofCores; do
+                   [ $n -le $nofCores ] && echo $n
+                 done | sort -nu | tr '\n' ' ')
+fi
+
+# workloads: name e+ pi+ protons neutrons momentum(GeV) events/thread
+workloads="
+bunch    4200 2200 1100    0 1.5  2
+p1GeV    5700 1100 1100    0 1.0  2
+p2GeV    3100 3700 1100    0 2.0  2
+neutrons    0    0    0 1000 1.5 10
+startup     0    0    0    0 1.5  0
+"
+
+echo "workload,threads,events_per_s,primaries_per_s,steps_per_s,\
+peak_rss_mb,startup_s" > "$output"
+
+log=$(mktemp)
+trap 'rm -f "$log"' EXIT
+nofFailures=0
+
+# the loop reads a here-document and not a pipe, so that it runs in this
+# shell and counts the failures
+while read name positrons pions protons neutrons momentum eventsPerThread
+do
+  [ -z "$name" ] && continue
+  for threads in $threadCounts; do
+    events=$((eventsPerThread * threads))
+    warmup=$((events > 0 ? 1 : 0))
+    primaries=$((positrons + pions + protons + neutrons))
+    echo " Running $name with $threads thread(s)" >&2
+    BENCH_POSITRONS=$positrons BENCH_PIONS=$pions BENCH_PROTONS=$protons \
+    BENCH_NEUTRONS=$neutrons BENCH_MOMENTUM=$momentum \
+    BENCH_WARMUP=$warmup BENCH_EVENTS=$events \
+      ./exampleB4d -m bench.mac -t $threads > "$log" 2>&1
+    status=$?
+    if [ $status -ne 0 ]; then
+      echo " FAILED $name $threads threads: exit status $status" >&2
+      tail -n 20 "$log" >&2
+      nofFailures=$((nofFailures + 1))
+      continue
+    fi
+
+    row=$(awk -v name=$name -v threads=$threads -v primaries=$primaries '
+        / Event rate: /   { eventRate = $3 }
+        / Steps: /        { stepRate = $6 }
+        / Memory \(RSS\): / { peakMemory = $11 }
+        /Startup time/    { inStartup = 1; startup = 0; next }
+        inStartup && /^---/ { inStartup = 0 }
+        inStartup && !/ Phase / && !/ total / && !/ first event / &&
+          !/ the CPU time / { startup += $(NF - 1) }
+        END {
+          primaryRate = (eventRate == "") ? "" : eventRate * primaries
+          printf "%s,%d,%s,%s,%s,%s,%s\n", name, threads, eventRate,
+                 primaryRate, stepRate, peakMemory, startup
+        }' "$log")
+    echo "$row" >> "$output"
+
+    # the rates are reported by the runs with events only
+    eventRate=$(echo "$row" | cut -d, -f3)
+    stepRate=$(echo "$row" | cut -d, -f5)
+    if [ $events -gt 0 ] && [ -z "$eventRate" -o -z "$stepRate" ]; then
+      echo " FAILED $name $threads threads: no events/s or steps/s" >&2
+      nofFailures=$((nofFailures + 1))
+    fi
+  done
+done <<END_OF_WORKLOADS
+$workloads
+END_OF_WORKLOADS
+
+echo " Benchmark results written in $output"
+column -s, -t "$output" 2>/dev/null || cat "$output"
+
+if [ $nofFailures -gt 0 ]; then
+  echo " $nofFailures failed run(s)" >&2
+  exit 1
+fi
+[ -z "$baseline" ] && exit 0
+
+# comparison with the baseline: the throughputs must not decrease, the
+# memory and the startup time must not increase, by more than threshold %;
+# all the results of the baseline must be present
+awk -F, -v threshold=$threshold '
+  FNR == 1 { next }
+  NR == FNR {
+    baseKeys[$1 "," $2] = 1
+    for (i = 3; i <= NF; ++i) base[$1 "," $2, i] = $i
+    next
+  }
+  {
+    key = $1 "," $2
+    found[key] = 1
+    for (i = 3; i <= NF; ++i) {
+      if (base[key, i] == "") continue
+      if ($i == "") {
+        printf " MISSING %s %d threads %s\n", $1, $2, column[i]
+        ++nofMissing
+        continue
+      }
+      if (base[key, i] == 0) continue
+      change = 100. * ($i - base[key, i]) / base[key, i]
+      worse = (i <= 5) ? -change : change
+      if (worse > threshold) {
+        printf " REGRESSION %s %d threads %s: %g -> %g (%+.1f %%)\n",
+               $1, $2, column[i], base[key, i], $i, change
+        ++nofRegressions
+      }
+    }
+  }
+  BEGIN {
+    column[3] = "events/s"; column[4] = "primaries/s"; column[5] = "steps/s"
+    column[6] = "peak RSS (MB)"; column[7] = "startup (s)"
+  }
+  END {
+    for (key in baseKeys) {
+      if (!(key in found)) {
+        split(key, names, ",")
+        printf " MISSING %s %d threads: not in the results\n", names[1],
+               names[2]
+        ++nofMissing
+      }
+    }
+    if (nofMissing > 0) printf " %d missing result(s)\n", nofMissing
+    if (nofRegressions > 0) {
+      printf " %d regression(s) over %g %%\n", nofRegressions, threshold
+    }
+    if (nofMissing > 0 || nofRegressions > 0) exit 1
+    printf " No regression over %g %% against the baseline\n", threshold
+  }' "$baseline" "$output"
@@ -0,0 +1,320 @@
+#!/bin/sh
+# Golden output equivalence harness of exampleB4d
+#
+# The neutron spectra of the ring detectors and of NDet (the _spectra.csv
+# files) and the neutron counts of the detectors are compared:
+# - bin by bin, exactly, between the serial, MT, tasking and adaptive run
+#   managers and between the ring and legacy ring scorers: the events are
+#   reseeded from the event ID (/B4/gun/eventSeed), so the same neutrons
+#   are scored whatever the threads; the readout of the EventAction is
+#   compared exactly too: the TCount histogram and the rows of the B4
+#   ntuple (TCount and the Detectors counts), sorted, as the worker
+#   threads write their own ntuple files;
+# - in distribution between the target scoring in the parallel world or
+#   overlapping the Target, and between the subtraction and nested NDet
+#   shells: their navigation differs, which changes the random sequence of
+#   the events; the counts of each detector per event (the Detectors rows
+#   of the B4 ntuple) are compared with a Welch t-test at the alpha level,
+#   which uses their variance between the events: the neutrons of a bunch
+#   are not independent, their counts are not Poisson distributed;
+# - bin by bin, exactly, against a golden spectra file (-g), eg. written
+#   with -G before a change of the scorers, to check the new
+#   implementation against the old one.
+#
+# usage: ./equivalence.sh [-n events] [-t threads] [-a alpha]
+#                         [-g golden.csv | -G golden.csv]
+# -G writes the spectra of the serial run in the golden file, -g compares
+# them with it. The run outputs are written in B4_eq_<run>*; the script
+# fails when a comparison fails. It needs a multi-threaded build.
+#
+events=8
+threads=4
+alpha=0.01
+golden=
+writeGolden=
+while getopts "n:t:a:g:G:" option; do
+  case $option in
+    n) events=$OPTARG ;;
+    t) threads=$OPTARG ;;
+    a) alpha=$OPTARG ;;
+    g) golden=$OPTARG ;;
+    G) writeGolden=$OPTARG ;;
+    *) sed -n '24,25p' "$0" >&2; exit 2 ;;
+  esac
+done
+if [ -n "$golden" ] && [ -n "$writeGolden" ]; then
+  sed -n '24,25p' "$0" >&2
+  exit 2
+fi
+if [ -n "$golden" ] && [ ! -f "$golden" ]; then
+  echo " Golden spectra $golden not found; write them with -G" >&2
+  exit 2
+fi
+
+nofFailures=0
+
+# run name ringScorer targetScoring shell exampleB4d-options...
+run() {
+  name=$1 ringScorer=$2 targetScoring=$3 shell=$4
+  shift 4
+  echo " Running $name: $*"
+  rm -f B4_eq_${name}_spectra.csv B4_eq_${name}_h1_*.csv B4_eq_${name}_nt_*.csv
+  EQ_EVENTS=$events EQ_RING_SCORER=$ringScorer EQ_SHELL=$shell \
+  EQ_OUTPUT=B4_eq_$name \
+    ./exampleB4d -m equivalence.mac -s $targetScoring "$@" \
+    > B4_eq_$name.log 2>&1
+  if [ $? -ne 0 ] || [ ! -f B4_eq_${name}_spectra.csv ]; then
+    echo " FAILED: $name did not run, see B4_eq_$name.log"
+    nofFailures=$((nofFailures + 1))
+  fi
+}
+
+# compare the spectra of two runs bin by bin, exactly
+# compare reference.csv test.csv
+compare() {
+  echo " Comparing $2 to $1 (exact)"
+  [ -f "$1" ] && [ -f "$2" ] || return
+  awk -F, '
+    /^#/ || $1 == "detector" { next }
+    NR == FNR { reference[$1 "," $2 "," $3] = $5; next }
+    {
+      bin = $1 "," $2 "," $3
+      tested[bin] = 1
+      key = $1 "," $2
+      if (!(key in group)) {
+        group[key] = ++nofGroups
+        detector[nofGroups] = $1
+        spectrum[nofGroups] = $2
+      }
+      g = group[key]
+      if (!(bin in reference)) {
+        printf "   %s %s: bin %s missing in the reference\n", $1, $2, $3
+        ++nofFailures
+        next
+      }
+      if (reference[bin] != $5) ++differences[g]
+      total1[g] += reference[bin]
+      total2[g] += $5
+    }
+    END {
+      for (bin in reference) {
+        if (!(bin in tested)) {
+          split(bin, fields, ",")
+          printf "   %s %s: bin %s missing in the test\n", fields[1],
+                 fields[2], fields[3]
+          ++nofFailures
+        }
+      }
+      for (g = 1; g <= nofGroups; ++g) {
+        if (spectrum[g] == "energy") {
+          printf "   %-6s %12g %12g neutrons\n", detector[g], total1[g],
+                 total2[g]
+        }
+        if (differences[g] > 0) {
+          printf "   %s %s: %d bin(s) differ\n", detector[g], spectrum[g],
+                 differences[g]
+          ++nofFailures
+        }
+      }
+      if (nofFailures > 0) {
+        printf "   FAILED: %d difference(s)\n", nofFailures
+        exit 1
+      }
+      print "   OK"
+    }' "$1" "$2" || nofFailures=$((nofFailures + 1))
+}
+
+# rows of an analysis output of a run, sorted, without the comment lines
+# rows name output
+rows() {
+  cat B4_eq_$1_$2*.csv 2>/dev/null | grep -v '^#' | sort
+}
+
+# compare the EventAction readout of two runs exactly
+# compareReadout referenceName testName
+compareReadout() {
+  for output in h1_TCount nt_B4; do
+    echo " Comparing the $output readout of $2 to $1 (exact)"
+    rows $1 $output > B4_eq_reference.rows
+    rows $2 $output > B4_eq_test.rows
+    if [ ! -s B4_eq_reference.rows ] || [ ! -s B4_eq_test.rows ]; then
+      echo "   FAILED: no $output output"
+      nofFailures=$((nofFailures + 1))
+    elif ! cmp -s B4_eq_reference.rows B4_eq_test.rows; then
+      echo "   FAILED: the rows differ"
+      diff B4_eq_reference.rows B4_eq_test.rows | head -n 10
+      nofFailures=$((nofFailures + 1))
+    else
+      echo "   OK"
+    fi
+  done
+  rm -f B4_eq_reference.rows B4_eq_test.rows
+}
+
+# compare the counts per event of two runs in distribution: Welch t-test
+# of the mean count of each detector, on the Detectors rows of the B4
+# ntuple (the TCount column and the Detectors vector, whose elements are
+# separated by ";")
+# compareDistribution referenceName testName
+compareDistribution() {
+  echo " Comparing the counts per event of $2 to $1 (distribution)"
+  rows $1 nt_B4 > B4_eq_reference.rows
+  rows $2 nt_B4 > B4_eq_test.rows
+  if [ ! -s B4_eq_reference.rows ] || [ ! -s B4_eq_test.rows ]; then
+    echo "   FAILED: no nt_B4 output"
+    nofFailures=$((nofFailures + 1))
+    rm -f B4_eq_reference.rows B4_eq_test.rows
+    return
+  fi
+  awk -F '[,;]' -v alpha=$alpha '
+    function abs(x) { return (x < 0) ? -x : x }
+    # logarithm of the gamma function (Lanczos)
+    function lnGamma(x,   c, y, tmp, series, j) {
+      split("76.18009172947146 -86.50532032941677 24.01409824083091 " \
+            "-1.231739572450155 0.1208650973866179e-2 " \
+            "-0.5395239384953e-5", c, " ")
+      y = x
+      tmp = x + 5.5
+      tmp -= (x + 0.5) * log(tmp)
+      series = 1.000000000190015
+      for (j = 1; j <= 6; ++j) series += c[j] / ++y
+      return -tmp + log(2.5066282746310005 * series / x)
+    }
+    # continued fraction of the incomplete beta function
+    function betaFraction(a, b, x,   m, m2, aa, c, d, delta, h) {
+      c = 1
+      d = 1 - (a + b) * x / (a + 1)
+      if (abs(d) < 1e-30) d = 1e-30
+      d = 1 / d
+      h = d
+      for (m = 1; m <= 300; ++m) {
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((a - 1 + m2) * (a + m2))
+        d = 1 + aa * d; if (abs(d) < 1e-30) d = 1e-30
+        c = 1 + aa / c; if (abs(c) < 1e-30) c = 1e-30
+        d = 1 / d
+        h *= d * c
+        aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + 1 + m2))
+        d = 1 + aa * d; if (abs(d) < 1e-30) d = 1e-30
+        c = 1 + aa / c; if (abs(c) < 1e-30) c = 1e-30
+        d = 1 / d
+        delta = d * c
+        h *= delta
+        if (abs(delta - 1) < 1e-12) break
+      }
+      return h
+    }
+    # regularized incomplete beta function
+    function betaIncomplete(a, b, x,   front) {
+      if (x <= 0) return 0
+      if (x >= 1) return 1
+      front = lnGamma(a + b) - lnGamma(a) - lnGamma(b)
+      front = exp(front + a * log(x) + b * log(1 - x))
+      if (x < (a + 1) / (a + b + 2)) return front * betaFraction(a, b, x) / a
+      return 1 - front * betaFraction(b, a, 1 - x) / b
+    }
+    # two-sided probability of the Student t distribution
+    function tProbability(t, ndf) {
+      return betaIncomplete(ndf / 2, 0.5, ndf / (ndf + t * t))
+    }
+    # detectors: Gap ... GapN, TargetDet, NDet
+    function name(i) {
+      if (i == nofDetectors) return "NDet"
+      if (i == nofDetectors - 1) return "TargetDet"
+      return (i == 1) ? "Gap" : "Gap" i
+    }
+    /^#/ || NF < 2 { next }
+    {
+      s = (NR == FNR) ? 1 : 2
+      if (nofDetectors == 0) nofDetectors = NF - 1
+      if (NF - 1 != nofDetectors) {
+        printf "   FAILED: %d detectors instead of %d\n", NF - 1,
+               nofDetectors
+        failed = 1
+        exit 1
+      }
+      ++n[s]
+      for (i = 1; i <= nofDetectors; ++i) {
+        sum[s, i] += $(i + 1)
+        sum2[s, i] += $(i + 1) * $(i + 1)
+      }
+    }
+    END {
+      if (failed) exit 1
+      if (n[1] < 2 || n[2] < 2) {
+        printf "   FAILED: %d and %d event(s), 2 at least are needed\n",
+               n[1], n[2]
+        exit 1
+      }
+      printf "   %-9s %12s %12s %10s %10s\n", "", "reference", "test", "t",
+             "p"
+      for (i = 1; i <= nofDetectors; ++i) {
+        for (s = 1; s <= 2; ++s) {
+          mean[s] = sum[s, i] / n[s]
+          variance[s] = (sum2[s, i] - n[s] * mean[s] * mean[s]) / (n[s] - 1)
+          if (variance[s] < 0) variance[s] = 0
+          error2[s] = variance[s] / n[s]
+        }
+        error2Sum = error2[1] + error2[2]
+        if (error2Sum > 0) {
+          t = (mean[1] - mean[2]) / sqrt(error2Sum)
+          # Welch-Satterthwaite degrees of freedom
+          ndf = error2[1] * error2[1] / (n[1] - 1)
+          ndf += error2[2] * error2[2] / (n[2] - 1)
+          ndf = error2Sum * error2Sum / ndf
+          p = tProbability(t, ndf)
+        } else {
+          t = 0
+          p = (mean[1] == mean[2]) ? 1 : 0
+        }
+        printf "   %-9s %12g %12g %10.3g %10.3g\n", name(i), mean[1],
+               mean[2], t, p
+        if (p < alpha) {
+          printf "   %s: p = %.3g < %g\n", name(i), p, alpha
+          ++nofFailures
+        }
+      }
+      if (nofFailures > 0) {
+        printf "   FAILED: %d difference(s)\n", nofFailures
+        exit 1
+      }
+      print "   OK"
+    }' B4_eq_reference.rows B4_eq_test.rows || nofFailures=$((nofFailures + 1))
+  rm -f B4_eq_reference.rows B4_eq_test.rows
+}
+
+run serial   ring   parallel subtraction -r serial
+run mt       ring   parallel subtraction -r mt -t $threads
+run tasking  ring   parallel subtraction -r tasking -t $threads
+run adaptive ring   parallel subtraction -r adaptive -t $threads
+run legacy   legacy parallel subtraction -t $threads
+run overlap  ring   overlap  subtraction -t $threads
+run nested   ring   parallel nested      -t $threads
+
+reference=B4_eq_serial_spectra.csv
+for name in mt tasking adaptive legacy; do
+  compare $reference B4_eq_${name}_spectra.csv
+  compareReadout serial $name
+done
+for name in overlap nested; do
+  compareDistribution serial $name
+done
+
+if [ -n "$golden" ]; then
+  compare "$golden" $reference
+fi
+if [ -n "$writeGolden" ]; then
+  if [ -f $reference ]; then
+    cp $reference "$writeGolden"
+    echo " Golden spectra written in $writeGolden"
+  else
+    echo " FAILED: no serial spectra to write in $writeGolden"
+    nofFailures=$((nofFailures + 1))
+  fi
+fi
+
+if [ $nofFailures -gt 0 ]; then
+  echo " Equivalence: $nofFailures failure(s)"
+  exit 1
+fi
+echo " Equivalence: all the comparisons passed"
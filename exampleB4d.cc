@@ -29,8 +29,16 @@
 
 #include "DetectorConstruction.hh"
 #include "ActionInitialization.hh"
+#include "AdaptiveRunManager.hh"
+#include "PhysicsTableCache.hh"
+#include "StartupProfiler.hh"
+#include "TargetParallelWorld.hh"
+#include "WorkerInitialization.hh"
 
 #include "G4AnalysisManager.hh"
+#include "G4FastSimulationPhysics.hh"
+#include "G4MTRunManager.hh"
+#include "G4ParallelWorldPhysics.hh"
 #include "G4RunManagerFactory.hh"
 #include "G4SteppingVerbose.hh"
 #include "G4TScoreNtupleWriter.hh"
@@ -47,9 +55,21 @@ namespace {
   void PrintUsage() {
     G4cerr << " Usage: " << G4endl;
     G4cerr << " exampleB4d [-m macro ] [-u UIsession] [-t nThreads] [-vDefault]"
-           << G4endl;
-    G4cerr << "   note: -t option is available only for multi-threaded mode."
-           << G4endl;
+           << " [-vis]" << G4endl;
+    G4cerr << "            [-r serial|mt|tasking|adaptive] [-e eventModulo]"
+           << " [-p none|core|numa]" << G4endl;
+    G4cerr << "            [-s parallel|overlap] [-f]" << G4endl;
+    G4cerr << "   note: -t, -e, -p and -r adaptive options are available only"
+           << " for multi-threaded mode." << G4endl;
+    G4cerr << "   note: without -r, the run manager is the default one, or"
+           << " the one of G4RUN_MANAGER_TYPE." << G4endl;
+    G4cerr << "   note: in batch mode (-m), the visualization is built only"
+           << " with -vis." << G4endl;
+    G4cerr << "   note: -s selects the target scoring volume placement, in a"
+           << " parallel world (default)" << G4endl
+           << "         or overlapping the Target." << G4endl;
+    G4cerr << "   note: -f registers the fast simulation physics, needed by"
+           << " the /B4/fast/ commands." << G4endl;
   }
 }
 
@@ -57,9 +77,12 @@ namespace {
 
 int main(int argc,char** argv)
 {
+  // Time the startup phases
+  auto startupProfiler = new B4d::StartupProfiler();
+
   // Evaluate arguments
   //
-  if ( argc > 7 ) {
+  if ( argc > 18 ) {
     PrintUsage();
     return 1;
   }
@@ -67,21 +90,66 @@ int main(int argc,char** argv)
   G4String macro;
   G4String session;
   G4bool verboseBestUnits = true;
+  G4bool batchVisualization = false;
+  auto runManagerType = G4RunManagerType::Default;
+  G4bool adaptiveRunManager = false;
+  G4String targetScoring = "parallel";
+  G4bool fastSimulation = false;
 #ifdef G4MULTITHREADED
   G4int nThreads = 0;
+  G4int eventModulo = 0;
+  G4String pinning;
 #endif
   for ( G4int i=1; i<argc; i=i+2 ) {
     if      ( G4String(argv[i]) == "-m" ) macro = argv[i+1];
     else if ( G4String(argv[i]) == "-u" ) session = argv[i+1];
+    else if ( G4String(argv[i]) == "-r" ) {
+      G4String type = argv[i+1];
+      if      ( type == "serial" )  runManagerType = G4RunManagerType::Serial;
+      else if ( type == "mt" )      runManagerType = G4RunManagerType::MT;
+      else if ( type == "tasking" ) runManagerType = G4RunManagerType::Tasking;
+#ifdef G4MULTITHREADED
+      else if ( type == "adaptive" ) adaptiveRunManager = true;
+#endif
+      else {
+        PrintUsage();
+        return 1;
+      }
+    }
 #ifdef G4MULTITHREADED
     else if ( G4String(argv[i]) == "-t" ) {
       nThreads = G4UIcommand::ConvertToInt(argv[i+1]);
     }
+    else if ( G4String(argv[i]) == "-e" ) {
+      eventModulo = G4UIcommand::ConvertToInt(argv[i+1]);
+    }
+    else if ( G4String(argv[i]) == "-p" ) {
+      pinning = argv[i+1];
+      if ( pinning != "none" && pinning != "core" && pinning != "numa" ) {
+        PrintUsage();
+        return 1;
+      }
+    }
 #endif
+    else if ( G4String(argv[i]) == "-s" ) {
+      targetScoring = argv[i+1];
+      if ( targetScoring != "parallel" && targetScoring != "overlap" ) {
+        PrintUsage();
+        return 1;
+      }
+    }
+    else if ( G4String(argv[i]) == "-f" ) {
+      fastSimulation = true;
+      --i;  // this option is not followed with a parameter
+    }
     else if ( G4String(argv[i]) == "-vDefault" ) {
       verboseBestUnits = false;
       --i;  // this option is not followed with a parameter
     }
+    else if ( G4String(argv[i]) == "-vis" ) {
+      batchVisualization = true;
+      --i;  // this option is not followed with a parameter
+    }
     else {
       PrintUsage();
       return 1;
@@ -104,32 +172,81 @@ int main(int argc,char** argv)
     G4SteppingVerbose::UseBestUnit(precision);
   }
 
-  // Construct the default run manager
+  // Construct the run manager: serial, MT, tasking or MT with adaptive event
+  // chunks with -r, else the default one
   //
-  auto runManager =
-    G4RunManagerFactory::CreateRunManager(G4RunManagerType::Default);
+  auto runManager = adaptiveRunManager
+                    ? new B4d::AdaptiveRunManager()
+                    : G4RunManagerFactory::CreateRunManager(runManagerType);
 #ifdef G4MULTITHREADED
   if ( nThreads > 0 ) {
     runManager->SetNumberOfThreads(nThreads);
   }
+  // the event modulo can be also set via /run/eventModulo
+  auto mtRunManager = dynamic_cast<G4MTRunManager*>(runManager);
+  if ( mtRunManager && eventModulo > 0 ) {
+    mtRunManager->SetEventModulo(eventModulo);
+  }
+  // worker thread pinning, also set via /B4/run/pinning
+  auto workerInitialization = new B4d::WorkerInitialization();
+  if ( pinning.size() ) {
+    workerInitialization->SetPinning(pinning);
+  }
+  runManager->SetUserInitialization(workerInitialization);
 #endif
 
   // Set mandatory initialization classes
   //
   auto detConstruction = new B4d::DetectorConstruction();
+  // parallel world of the target scoring volume, only when it is used, so
+  // that the overlap mode does not pay for the parallel world process
+  G4String targetWorldName = "TargetWorld";
+  detConstruction->SetTargetScoring(targetScoring);
+  detConstruction->SetFastSimulation(fastSimulation);
+  if ( targetScoring == "parallel" ) {
+    detConstruction->RegisterParallelWorld(
+      new B4d::TargetParallelWorld(targetWorldName, detConstruction));
+  }
   runManager->SetUserInitialization(detConstruction);
+  // lean batch mode: no overlap checks and material print, unless requested
+  // with /B4/det/checkOverlaps and /B4/det/printMaterials
+  if ( macro.size() ) {
+    detConstruction->SetCheckOverlaps(false);
+    detConstruction->SetPrintMaterials(false);
+  }
 
   auto physicsList = new FTFP_BERT;
+  if ( targetScoring == "parallel" ) {
+    physicsList->RegisterPhysics(new G4ParallelWorldPhysics(targetWorldName));
+  }
+  // fast shower model in the Target, enabled with /B4/fast/enable; its
+  // physics is registered only on request, as its process is applied to all
+  // the e+, e- and gamma steps even when the model is disabled
+  if ( fastSimulation ) {
+    auto fastSimulationPhysics = new G4FastSimulationPhysics();
+    fastSimulationPhysics->ActivateFastSimulation("e-");
+    fastSimulationPhysics->ActivateFastSimulation("e+");
+    fastSimulationPhysics->ActivateFastSimulation("gamma");
+    physicsList->RegisterPhysics(fastSimulationPhysics);
+  }
   runManager->SetUserInitialization(physicsList);
+  // physics table cache, enabled with /B4/physics/tableCache
+  auto physicsTableCache =
+    new B4d::PhysicsTableCache(physicsList, "FTFP_BERT");
 
   auto actionInitialization = new B4d::ActionInitialization();
   runManager->SetUserInitialization(actionInitialization);
 
-  // Initialize visualization
-  auto visManager = new G4VisExecutive;
-  // G4VisExecutive can take a verbosity argument - see /vis/verbose guidance.
-  // auto visManager = new G4VisExecutive("Quiet");
-  visManager->Initialize();
+  // Initialize visualization, in batch mode only if requested: it registers
+  // all the graphics systems
+  G4VisManager* visManager = nullptr;
+  if ( ! macro.size() || batchVisualization ) {
+    visManager = new G4VisExecutive;
+    // G4VisExecutive can take a verbosity argument - see /vis/verbose
+    // guidance.
+    // visManager = new G4VisExecutive("Quiet");
+    visManager->Initialize();
+  }
 
   // Get the pointer to the User Interface manager
   auto UImanager = G4UImanager::GetUIpointer();
@@ -167,6 +284,8 @@ int main(int argc,char** argv)
   // owned and deleted by the run manager, so they should not be deleted
   // in the main() program !
 
+  delete physicsTableCache;
+  delete startupProfiler;
   delete visManager;
   delete runManager;
 }
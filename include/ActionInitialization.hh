@@ -31,20 +31,63 @@
 #define B4dActionInitialization_h 1
 
 #include "G4VUserActionInitialization.hh"
+#include "ConvergenceMonitor.hh"
+#include "PhaseSpace.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "StackingAction.hh"
+#include "SteppingAction.hh"
+
+class G4GenericMessenger;
 
 namespace B4d
 {
 
 /// Action initialization class.
+///
+/// It also owns the parameters of the user actions which are shared by all
+/// threads, together with the UI commands which define them:
+/// - /B4/stack/ : StackingAction parameters
+/// - /B4/gun/   : PrimaryGeneratorAction parameters
+/// - /B4/phsp/  : phase space file parameters (two-stage simulation)
+/// - /B4/conv/  : ConvergenceMonitor parameters (adaptive run length)
+/// - /B4/kill/  : kill zone parameters of the SteppingAction
+/// - /B4/bias/  : neutron biasing parameters of the SteppingAction
+/// - /B4/profile/ : profiling of the stepping loop (see StepProfile)
+/// - /B4/response/ : ResponseLibrary file and bunch predictions
+/// - /B4/scan/  : scan of beam and ring configurations, run one after the
+///                other in the same process (see RunScan())
 
 class ActionInitialization : public G4VUserActionInitialization
 {
   public:
-    ActionInitialization() = default;
-    ~ActionInitialization() override = default;
+    ActionInitialization();
+    ~ActionInitialization() override;
 
     void BuildForMaster() const override;
     void Build() const override;
+
+  private:
+    void DefineCommands();
+    void SetResponseFile(const G4String& fileName);
+    void CombineResponses(const G4String& parameters);
+    void RunScan(const G4String& parameters);
+
+    StackingParameters fStackingParameters;
+    B4::GunParameters fGunParameters;
+    PhaseSpaceParameters fPhaseSpaceParameters;
+    ConvergenceParameters fConvergenceParameters;
+    KillParameters fKillParameters;
+    BiasingParameters fBiasingParameters;
+    ProfileParameters fProfileParameters;
+    G4GenericMessenger* fStackMessenger = nullptr;
+    G4GenericMessenger* fGunMessenger = nullptr;
+    G4GenericMessenger* fPhaseSpaceMessenger = nullptr;
+    G4GenericMessenger* fConvergenceMessenger = nullptr;
+    G4GenericMessenger* fKillMessenger = nullptr;
+    G4GenericMessenger* fBiasingMessenger = nullptr;
+    G4GenericMessenger* fProfileMessenger = nullptr;
+    G4GenericMessenger* fResponseMessenger = nullptr;
+    G4GenericMessenger* fScanMessenger = nullptr;
 };
 
 }
@@ -0,0 +1,82 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/AdaptiveRunManager.hh
+/// \brief Definition of the B4d::AdaptiveRunManager class
+
+#ifndef B4dAdaptiveRunManager_h
+#define B4dAdaptiveRunManager_h 1
+
+#include "G4MTRunManager.hh"
+#include "G4Threading.hh"
+
+namespace B4d {
+
+/// Multi-threaded run manager with adaptive event chunks
+///
+/// The G4MTRunManager hands the events to the workers in chunks of a fixed
+/// size, the event modulo. With heavy events of variable cost, the last
+/// chunks finish late and the other workers wait at the end of the run.
+/// Here the size of each chunk is computed when a worker asks for events:
+///   chunk = remaining events x share of the worker / 2,
+/// where the share is the event rate of the worker over the sum of the
+/// rates of all workers, measured online by the WorkerTimeline (1/N before
+/// the first events). The chunks thus shrink as the run proceeds, down to
+/// one event at the tail, and a slower worker gets smaller chunks. The
+/// chunk is not made shorter than fMinChunkTime, to keep the requests of
+/// cheap events rare. /run/eventModulo is not used.
+///
+/// The events keep their own seeds, so that the results do not depend on
+/// the chunks, unless the seeds are set once per chunk (/run/eventModulo
+/// N 1), in which case the fixed event modulo is used.
+///
+/// It is selected with -r adaptive in main().
+
+class AdaptiveRunManager : public G4MTRunManager {
+public:
+  AdaptiveRunManager() = default;
+  ~AdaptiveRunManager() override = default;
+
+  G4int SetUpNEvents(G4Event *event, G4SeedsQueue *seedsQueue,
+                     G4bool reseedRequired = true) override;
+  void RunTermination() override;
+
+private:
+  G4int GetChunkSize() const;
+
+  G4double fMinChunkTime = 0.1; // s
+  G4int fNofChunks = 0;
+  G4int fMinChunkSize = 0;
+  G4int fMaxChunkSize = 0;
+  G4Mutex fMutex;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
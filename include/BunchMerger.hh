@@ -0,0 +1,79 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/BunchMerger.hh
+/// \brief Definition of the B4d::BunchMerger class
+
+#ifndef B4dBunchMerger_h
+#define B4dBunchMerger_h 1
+
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <map>
+#include <vector>
+
+namespace B4d {
+
+/// Bunch merger class
+///
+/// In the sub-event mode a bunch is split in several chunks of primaries,
+/// each tracked as a separate event, possibly on different threads.
+/// The per-event detector records of the chunks of a bunch are summed here;
+/// the thread which completes a bunch gets the bunch totals back and fills
+/// the output. The merger is shared by all threads.
+
+class BunchMerger {
+public:
+  static BunchMerger *Instance();
+
+  /// Clear the bunches of the previous run
+  void Clear();
+
+  /// Add the record of one chunk of the bunch; return true if the bunch is
+  /// complete, the record being then replaced by the bunch totals
+  G4bool AddChunk(G4int bunchID, G4int nofChunks,
+                  std::vector<G4double> &record);
+
+  G4int GetNofIncompleteBunches() const;
+
+private:
+  BunchMerger() = default;
+
+  struct Bunch {
+    G4int nofChunks = 0;
+    std::vector<G4double> record;
+  };
+
+  std::map<G4int, Bunch> fBunches; // incomplete bunches
+  mutable G4Mutex fMutex;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
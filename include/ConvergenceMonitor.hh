@@ -0,0 +1,102 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/ConvergenceMonitor.hh
+/// \brief Definition of the B4d::ConvergenceMonitor class
+
+#ifndef B4dConvergenceMonitor_h
+#define B4dConvergenceMonitor_h 1
+
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace B4d {
+
+/// Convergence parameters.
+/// They are set via the /B4/conv/ commands defined in ActionInitialization
+/// and read by the master at the beginning of run.
+
+struct ConvergenceParameters {
+  G4double relativeError = 0.; // target relative error (0 = off)
+  G4double timeBudget = 0.;    // wall time budget (0 = no limit)
+  G4String detectors = "all";  // detectors which must converge
+  G4int minEvents = 10;        // events before the first check
+};
+
+/// Convergence monitor, shared by all threads.
+///
+/// The detector values of each event (or of each bunch, in the sub-event
+/// mode) are accumulated with their squares while the run proceeds, so that
+/// the relative error of the run totals is known at any time. Once all the
+/// requested detectors reach the target relative error, or once the wall
+/// time budget is exhausted, AddEvent() returns true: the threads then
+/// abort the run after their current event. /run/beamOn N gives an upper
+/// limit of the number of events.
+
+class ConvergenceMonitor {
+public:
+  static ConvergenceMonitor *Instance();
+
+  /// Start a run: the detector names are in the order of the event values
+  void Start(const ConvergenceParameters &parameters,
+             const std::vector<G4String> &detectorNames);
+
+  /// Add the values of one event; return true when the run must stop
+  G4bool AddEvent(const std::vector<G4double> &values);
+
+  G4bool IsActive() const { return fIsActive; }
+  void Print() const;
+
+private:
+  ConvergenceMonitor() = default;
+
+  G4bool IsConverged() const;
+  G4double GetElapsedTime() const;
+
+  std::atomic<G4bool> fIsActive = false;
+  std::atomic<G4bool> fIsStopped = false;
+  G4double fRelativeError = 0.;
+  G4double fTimeBudget = 0.;
+  G4int fMinEvents = 0;
+  std::vector<G4String> fDetectorNames;
+  std::vector<G4bool> fIsRequested;
+  G4int fNofEvents = 0;
+  std::vector<G4double> fSums;
+  std::vector<G4double> fSums2;
+  G4String fStopReason;
+  std::chrono::steady_clock::time_point fStartTime;
+  mutable G4Mutex fMutex;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -30,11 +30,22 @@
 #ifndef B4dDetectorConstruction_h
 #define B4dDetectorConstruction_h 1
 
+#include "TargetShowerModel.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
 #include "G4VUserDetectorConstruction.hh"
 #include "globals.hh"
 
+#include <array>
+#include <vector>
+
+class G4LogicalVolume;
+class G4Material;
 class G4VPhysicalVolume;
+class G4VSensitiveDetector;
 class G4GlobalMagFieldMessenger;
+class G4GenericMessenger;
 
 namespace B4d
 {
@@ -54,31 +65,157 @@ namespace B4d
 /// type with primitive scorers are created and associated with the Absorber
 /// and Gap volumes.  In addition a transverse uniform magnetic field is defined
 /// via G4GlobalMagFieldMessenger class.
+///
+/// The detector ring is made of one cylinder solid and logical volume placed
+/// at a given radius for each angle of a list, with the copy number equal
+/// to the index in the list. The ring is defined via the /B4/ring/ commands,
+/// which can be issued also between runs: the geometry is then rebuilt.
+/// The default ring is the one of the experiment: nine detectors at 80.5 cm,
+/// Gap ... Gap9 at 180, 150, 120, 90, 60, 30, 0, 330 and 210 degrees.
+///
+/// The neutrons entering the detectors of the ring are counted by a single
+/// RingSD indexed by the detector copy number. The original scorers can be
+/// selected instead with /B4/det/ringScorer legacy, eg. to compare the two
+/// implementations: each detector then has its own logical volume, gapLV,
+/// gapLV2, ..., placed with the copy number 0, and its own
+/// G4MultiFunctionalDetector with a G4PSTrackCounter, whose hits collections
+/// are "Gap/TrackCounter", "Gap2/TrackCounter2", ...
+///
+/// The Target can be left out with /B4/det/placeTarget false, for the
+/// stage 2 of the two-stage simulation (see PhaseSpace.hh).
+///
+/// The NDet shell, a hollow box, can be built in three ways, selected with
+/// /B4/det/shell:
+/// - subtraction: a G4SubtractionSolid of two boxes (default),
+/// - nested: a box with a daughter cavity box, in which the Target and the
+///   ring are placed; it scores identically, as the neutrons cross the same
+///   NDet boundaries,
+/// - slabs: six box slabs; the crossings from one slab to another near the
+///   edges are hidden from the NDet scorers by a ShellCrossingFilter, so
+///   that it scores identically too.
+/// /B4/det/benchmarkShell N times the navigation on the three constructions
+/// (see ShellBenchmark).
+///
+/// The Target is the TargetRegion, to which the TargetShowerModel is
+/// attached when the fast simulation physics is registered, with the -f
+/// option of main(): the EM showers in the Target can then be parameterized
+/// with the /B4/fast/ commands.
+///
+/// The target scoring volume TargetDet is placed in the TargetParallelWorld,
+/// registered in main(); the -s overlap option of main() places it in the
+/// mass geometry instead, overlapping the Target, as in the original setup,
+/// and then neither the parallel world nor its physics are registered.
+///
+/// The overlap checks and the material print can be switched off with
+/// /B4/det/checkOverlaps and /B4/det/printMaterials; they are off in the
+/// batch mode (see main()).
 
 class DetectorConstruction : public G4VUserDetectorConstruction
 {
   public:
-    DetectorConstruction() = default;
-    ~DetectorConstruction() override = default;
+    /// Box slab of the NDet shell
+    struct ShellSlab {
+      G4ThreeVector halfLengths;
+      G4ThreeVector position;
+    };
+
+    DetectorConstruction();
+    ~DetectorConstruction() override;
 
   public:
     G4VPhysicalVolume* Construct() override;
     void ConstructSDandField() override;
 
+    // set methods
+    void SetRingRadius(G4double radius);
+    void SetRingAngles(const G4String& angles);
+    void SetUniformRing(const G4String& parameters);
+    void SetDetectorDiameter(G4double diameter);
+    void SetDetectorHeight(G4double height);
+    void SetShell(const G4String& shell);
+    void SetCheckOverlaps(G4bool value) { fCheckOverlaps = value; }
+    void SetPrintMaterials(G4bool value) { fPrintMaterials = value; }
+    void SetTargetScoring(const G4String& mode) { fTargetScoring = mode; }
+    void SetFastSimulation(G4bool value) { fFastSimulation = value; }
+    void SetFastShowers(G4bool enable);
+
+    // get methods
+    G4int GetNofRingDetectors() const;
+    G4double GetRingRadius() const { return fRingRadius; }
+    const std::vector<G4double>& GetRingAngles() const { return fRingAngles; }
+    G4double GetDetectorDiameter() const { return fDetectorDiameter; }
+    G4double GetDetectorHeight() const { return fDetectorHeight; }
+    G4double GetShellHalfLength() const { return fShellHalfLength; }
+    const G4String& GetShell() const { return fShell; }
+    const G4String& GetTargetScoring() const { return fTargetScoring; }
+    G4bool GetCheckOverlaps() const { return fCheckOverlaps; }
+    G4bool GetFastSimulation() const { return fFastSimulation; }
+    const G4String& GetRingScorer() const { return fRingScorer; }
+    const FastShowerParameters& GetFastShowerParameters() const
+      { return fFastShowerParameters; }
+
+    /// The six slabs of a hollow box: the x slabs cover the full faces,
+    /// the y slabs fit between them and the z slabs between all the others
+    static std::array<ShellSlab, 6> GetShellSlabs(G4double outerHalfLength,
+                                                  G4double innerHalfLength);
+
+    /// Angles of the nine detectors of the original ring
+    static std::vector<G4double> GetDefaultRingAngles();
+
+    /// Hits collection of the legacy scorer of a ring detector
+    static G4String GetLegacyCollectionName(G4int detector);
+
   private:
     // methods
     //
     void DefineMaterials();
     G4VPhysicalVolume* DefineVolumes();
+    G4LogicalVolume* DefineShell(G4LogicalVolume* worldLV,
+                                 G4Material* material);
+    void BenchmarkShell(G4int nofPoints);
+    void ConstructScorers();
+    G4VSensitiveDetector* ConstructLegacyRingScorer(G4int detector) const;
+    void DefineCommands();
+    void GeometryHasChanged();
 
     // data members
     //
     static G4ThreadLocal G4GlobalMagFieldMessenger*  fMagFieldMessenger;
                             // magnetic field messenger
+    static G4ThreadLocal TargetShowerModel* fShowerModel;
+                            // fast shower model, created once per thread
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4GenericMessenger* fRingMessenger = nullptr;
+    G4GenericMessenger* fFastMessenger = nullptr;
+
+    // detector ring
+    G4double fRingRadius = 80.5 * cm;
+    std::vector<G4double> fRingAngles = GetDefaultRingAngles();
+    G4double fDetectorDiameter = 22.86 * cm;
+    G4double fDetectorHeight = 21 * cm;
+
+    // NDet shell: its outer surface bounds everything which is scored
+    G4double fShellHalfLength = 2.0 * m;
+    G4double fShellInnerHalfLength = 1.8 * m;
+    G4String fShell = "subtraction"; // construction: subtraction, nested, slabs
+    G4bool fGeometryChanged = false; // rebuild pending, the old world is freed
 
     G4bool fCheckOverlaps = true; // option to activate checking of volumes overlaps
+    G4bool fPrintMaterials = true; // print the material table
+    G4String fRingScorer = "ring"; // ring scorer implementation: ring, legacy
+    G4bool fPlaceTarget = true; // false for the phase space stage 2
+    G4String fTargetScoring = "parallel"; // TargetDet world: parallel, overlap
+    G4bool fFastSimulation = false; // fast simulation physics registered
+    FastShowerParameters fFastShowerParameters;
 };
 
+// inline functions
+
+inline G4int DetectorConstruction::GetNofRingDetectors() const {
+  return G4int(fRingAngles.size());
+}
+
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
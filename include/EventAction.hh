@@ -32,9 +32,17 @@
 
 #include "G4UserEventAction.hh"
 
+#include "RingSD.hh"
+
 #include "G4THitsMap.hh"
 #include "globals.hh"
 
+#include <vector>
+
+namespace B4 {
+struct GunParameters;
+}
+
 namespace B4d {
 
 /// Event action class
@@ -42,26 +50,55 @@ namespace B4d {
 /// In EndOfEventAction(), it prints the accumulated quantities of the energy
 /// deposit and track lengths of charged particles in Absober and Gap layers
 /// stored in the hits collections.
+///
+/// The neutron counts of the detector ring are read from the RingSD or,
+/// with the legacy ring scorers, from the Gap/TrackCounter,
+/// Gap2/TrackCounter2, ... hits collections, and added to the run totals.
+/// The hits collection IDs are resolved once.
+///
+/// The values of all the detectors are stored in one contiguous record:
+/// Gap ... GapN, TargetDet, NDet. It is written in the ntuple as the
+/// vector column Detectors, booked in RunAction via GetRecord().
+///
+/// In the sub-event mode, the records of the events carrying the chunks of
+/// a bunch are merged by the BunchMerger and the output is filled once per
+/// bunch, by the thread which processes its last chunk.
+///
+/// In the single species mode, the records are added to the response
+/// sums of the Run, from which the ResponseLibrary is built.
+///
+/// With the adaptive run length, the event (or bunch) records are passed
+/// to the ConvergenceMonitor and the run is aborted once it has converged.
+///
+/// The busy interval of each event is added to the WorkerTimeline.
 
 class EventAction : public G4UserEventAction {
 public:
-  EventAction() = default;
+  EventAction(const B4::GunParameters *gunParameters);
   ~EventAction() override = default;
 
   void BeginOfEventAction(const G4Event *event) override;
   void EndOfEventAction(const G4Event *event) override;
 
+  std::vector<G4double> &GetRecord() { return fRecord; }
+
 private:
   // methods
   G4THitsMap<G4double> *GetHitsCollection(G4int hcID,
                                           const G4Event *event) const;
-  G4double GetSum(G4THitsMap<G4double> *hitsMap) const;
+  G4double GetValue(G4int hcID, const G4Event *event) const;
   void PrintEventStatistics(G4double gapTrackCounter) const;
+  void ReadRingCounts(const G4Event *event);
 
   // data members
-  G4int fGapTrackCounterHCID = -1;
+  const B4::GunParameters *fGunParameters = nullptr;
+  RingSD *fRingSD = nullptr;
+  std::vector<G4int> fGapTrackCounterHCIDs; // legacy ring scorers
+  std::vector<G4double> fRingCounts;
+  std::vector<G4double> fRecord; // ring counts, target track length, NDet
   G4int fTargetTrackLengthHCID = -1;
   G4int fNTrackCounterHCID = -1;
+  G4double fEventStartTime = 0.; // in the WorkerTimeline
 };
 
 } // namespace B4d
@@ -0,0 +1,91 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/LambertianApproximation.hh
+/// \brief Definition of the B4d::LambertianApproximation class
+
+#ifndef B4dLambertianApproximation_h
+#define B4dLambertianApproximation_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+namespace B4d {
+
+/// Lambertian approximation of the neutrons reaching the detectors of the
+/// ring, scored from the Target exit points.
+///
+/// For each neutron leaving the Target surface, it adds to each detector
+/// d(Omega) cos(theta) / pi, where d(Omega) is the solid angle of the
+/// detector seen from the exit point and theta the angle to the outward
+/// surface normal: the actual exit direction of the neutron is replaced by
+/// an assumed cosine (Lambertian) distribution, that of an isotropic flux
+/// inside the Target. It is therefore not an estimator of the analog counts,
+/// whose deterministic contribution in the vacuum is the analog hit itself,
+/// but an approximation of them, biased where the real exit distribution is
+/// anisotropic, eg. for the forward cascade neutrons. Its errors cannot be
+/// compared to the analog ones; its ratio to the analog counts measures the
+/// anisotropy of the exit distribution.
+///
+/// The solid angle of a cylinder is approximated by its projected area
+/// divided by the squared distance to its centre (far field).
+
+class LambertianApproximation {
+public:
+  LambertianApproximation() = default;
+  ~LambertianApproximation() = default;
+
+  /// Define the ring: the detectors are cylinders with their axis
+  /// perpendicular to the ring plane (y axis), centred at the given
+  /// angles from the z axis towards the x axis.
+  void SetRing(G4double radius, const std::vector<G4double> &angles,
+               G4double diameter, G4double height);
+
+  /// Add to scores[i] the weighted probability that a neutron leaving the
+  /// Target at position, with the outward surface normal, reaches the
+  /// detector i. The scores array must hold GetNofDetectors() values.
+  void Score(const G4ThreeVector &position, const G4ThreeVector &normal,
+             G4double weight, G4double *scores) const;
+
+  std::size_t GetNofDetectors() const { return fX.size(); }
+
+private:
+  // detector centres
+  std::vector<G4double> fX;
+  std::vector<G4double> fY;
+  std::vector<G4double> fZ;
+  // projected areas: side (diameter x height) and end (disk) of a detector
+  G4double fSideArea = 0.;
+  G4double fEndArea = 0.;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,134 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/PhaseSpace.hh
+/// \brief Definition of the B4d phase space classes
+
+#ifndef B4dPhaseSpace_h
+#define B4dPhaseSpace_h 1
+
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <fstream>
+#include <vector>
+
+namespace B4d {
+
+/// Phase space parameters.
+/// They are set via the /B4/phsp/ commands defined in ActionInitialization
+/// and shared (read-only) by the user actions of all threads.
+///
+/// Stage 1 (full simulation): the neutrons leaving the Target are written
+/// to the output file.
+/// Stage 2 (detector studies): the primaries are neutrons taken from the
+/// input file, replayed in order or resampled at random.
+
+struct PhaseSpaceParameters {
+  // stage 1
+  G4String outputFile;          // no output if empty
+  G4bool killRecorded = false;  // stop the recorded neutrons
+  // stage 2
+  G4String inputFile;           // bunch generator if empty
+  G4String mode = "replay";     // replay or resample
+  G4int neutronsPerEvent = 1000;
+};
+
+/// Phase space record of a neutron leaving the Target.
+/// The units are mm, MeV and ns; the file is a "B4PS" header followed by
+/// the records, in the native byte order.
+
+struct PhaseSpaceRecord {
+  float x, y, z;
+  float dx, dy, dz;
+  float kinEnergy;
+  float time;
+  float weight;
+};
+
+/// Phase space writer, shared by all threads.
+///
+/// Each thread buffers its records, the buffer being flushed in the common
+/// file when it is full and at the end of run. The file is opened by the
+/// master at each run: it is created at the first run, and the records of
+/// the next runs of the job are appended to it.
+
+class PhaseSpaceWriter {
+public:
+  static PhaseSpaceWriter *Instance();
+
+  void Open(const G4String &fileName);
+  void Fill(const PhaseSpaceRecord &record);
+  void Flush();  // flush the buffer of this thread
+  void Close();
+
+  G4bool IsOpen() const { return fIsOpen; }
+
+private:
+  PhaseSpaceWriter() = default;
+
+  std::ofstream fFile;
+  G4String fFileName; // created in this job
+  std::atomic<G4bool> fIsOpen = false;
+  G4long fNofRecords = 0;
+  G4Mutex fMutex;
+};
+
+/// Phase space reader, shared by all threads.
+///
+/// The records are loaded once in memory by the master at the beginning of
+/// run, and then read by all threads without copying them and without
+/// locking.
+
+class PhaseSpaceReader {
+public:
+  static PhaseSpaceReader *Instance();
+
+  /// Load the file, if not yet done; on the master, before the workers
+  /// start their events
+  void Load(const G4String &fileName);
+
+  /// The records of the loaded file
+  const std::vector<PhaseSpaceRecord> &GetRecords() const { return fRecords; }
+
+  /// Index of the next record in the replay mode (shared by all threads)
+  std::size_t NextIndex();
+
+private:
+  PhaseSpaceReader() = default;
+
+  G4String fFileName;
+  std::vector<PhaseSpaceRecord> fRecords;
+  std::atomic<std::size_t> fNextIndex = 0;
+  G4Mutex fMutex;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
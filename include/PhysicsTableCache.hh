@@ -0,0 +1,92 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/PhysicsTableCache.hh
+/// \brief Definition of the B4d::PhysicsTableCache class
+
+#ifndef B4dPhysicsTableCache_h
+#define B4dPhysicsTableCache_h 1
+
+#include "G4VStateDependent.hh"
+#include "globals.hh"
+
+class G4GenericMessenger;
+class G4VUserPhysicsList;
+
+namespace B4d {
+
+/// Cache of the physics tables, on the master
+///
+/// When a cache directory is set with /B4/physics/tableCache, the physics
+/// tables built at the first run are stored in a subdirectory keyed by the
+/// physics list, the Geant4 version, the production cuts of all regions,
+/// the materials, the EM parameters and the paths of the data sets, and
+/// they are retrieved from it at the next start with the same key instead
+/// of being rebuilt. The key is also written in the subdirectory and
+/// compared in full before any retrieval. It is made
+/// when the first run initializes the physics, just before the tables are
+/// built, so that the cuts set after /run/initialize are included, and
+/// made again to store the tables when the geometry is closed.
+///
+/// The tables are retrieved on the master only: the retrieval flag is
+/// reset before the workers build their tables, so that they share the
+/// master tables as in any multi-threaded run, without copies. It is also
+/// reset for the later runs, so that a geometry change rebuilds the tables.
+///
+/// Only the tables of the processes which support storing (the
+/// electromagnetic tables) are cached; the others are built as usual.
+
+class PhysicsTableCache : public G4VStateDependent {
+public:
+  PhysicsTableCache(G4VUserPhysicsList *physicsList,
+                    const G4String &physicsListName);
+  ~PhysicsTableCache() override;
+
+  G4bool Notify(G4ApplicationState requestedState) override;
+
+private:
+  G4String MakeKey() const;
+  G4String GetTableDirectory(const G4String &key) const;
+  void Prepare();
+  void Finish();
+
+  G4VUserPhysicsList *fPhysicsList = nullptr;
+  G4String fPhysicsListName;
+  G4String fCacheDirectory;
+  G4String fTableDirectory;
+  G4String fKey;
+  G4bool fIsRetrieved = false;
+  G4bool fIsPrepared = false;
+  G4bool fIsDone = false;
+  G4GenericMessenger *fMessenger = nullptr;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -30,30 +30,119 @@
 #ifndef B4PrimaryGeneratorAction_h
 #define B4PrimaryGeneratorAction_h 1
 
+#include "G4SystemOfUnits.hh"
+#include "G4TrackVector.hh"
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "globals.hh"
 
+#include <utility>
+#include <vector>
+
+class G4ParticleDefinition;
 class G4ParticleGun;
+class G4PrimaryVertex;
 class G4Event;
 
+namespace B4d {
+struct PhaseSpaceParameters;
+struct StackingParameters;
+}
+
 namespace B4 {
 
+/// Primary generator parameters.
+/// They are set via the /B4/gun/ commands defined in B4d::ActionInitialization
+/// and shared (read-only) by the primary generator actions of all threads.
+
+struct GunParameters {
+  // bunch composition
+  G4int nofPositrons = 4200;
+  G4int nofPions = 2200;
+  G4int nofProtons = 1100;
+  G4int nofNeutrons = 0;
+  G4double momentum = 1.5 * CLHEP::GeV;
+
+  // sub-event mode: number of events (chunks) per bunch
+  G4int chunksPerBunch = 1;
+
+  // single species mode: one primary of this species per event, or a
+  // full bunch ("bunch")
+  G4String species = "bunch";
+
+  // deterministic event seeding: when not 0, the seeds of each event are
+  // derived from this seed and the event ID
+  G4int eventSeed = 0;
+};
+
 /// The primary generator action class with particle gum.
 ///
-/// It defines a single particle which hits the calorimeter
-/// perpendicular to the input face. The type of the particle
-/// can be changed via the G4 build-in commands of G4ParticleGun class
-/// (see the macros provided with this example).
+/// Each event is a bunch of e+, pi+ and protons shot along the x axis
+/// into the target; neutrons can be added, eg. for a neutron-only beam.
+///
+/// In the sub-event mode the bunch is split in chunksPerBunch consecutive
+/// events, event i carrying the chunk i % chunksPerBunch of the bunch
+/// i / chunksPerBunch. The chunks have the same composition as the bunch
+/// and their primaries add up to the bunch primaries; they can be tracked
+/// on different threads and are merged back in B4d::EventAction.
+///
+/// With the staged primary injection (see B4d::StackingAction), the bunch
+/// is split in batches of primariesPerStage primaries, with one primary
+/// vertex per species in each batch. Only the vertices of the first batch
+/// are added to the event; the others are kept by the generator, and
+/// ReleasePrimaries() adds the vertices of the next batch to the event and
+/// creates their tracks when the stacking action asks for it, so that the
+/// tracks of the later batches do not exist before. At the end of the
+/// event, its primary vertices are the whole bunch, as without staging.
+/// The staging does not apply to the phase space input.
+///
+/// In the single species mode, used to build the B4d::ResponseLibrary, each
+/// event is one primary of the given species, with the bunch momentum; the
+/// sub-event mode does not apply.
+///
+/// With an event seed, the random engine is reseeded at the start of each
+/// event from the event seed and the event ID: an event is then the same
+/// whatever the run manager and the thread which processes it, so that the
+/// serial, MT and tasking results can be compared bin by bin (see
+/// equivalence.sh).
+///
+/// In the stage 2 of the two-stage simulation, when a phase space input file
+/// is defined, each event is made of neutrons leaving the target read from
+/// the file, replayed in order or resampled at random (see
+/// B4d::PhaseSpaceParameters).
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
 public:
-  PrimaryGeneratorAction();
+  PrimaryGeneratorAction(
+      const GunParameters *parameters,
+      const B4d::PhaseSpaceParameters *phaseSpaceParameters,
+      const B4d::StackingParameters *stackingParameters);
   ~PrimaryGeneratorAction() override;
 
   void GeneratePrimaries(G4Event *event) override;
 
+  /// Add the primary vertices of the next batch to the event and create
+  /// the tracks of their primaries; nothing when all were released
+  void ReleasePrimaries(G4Event *event, G4TrackVector &tracks);
+
 private:
+  // species and number of the primaries of a bunch
+  using Bunch = std::vector<std::pair<G4ParticleDefinition *, G4int>>;
+
+  void GeneratePhaseSpacePrimaries(G4Event *event);
+  void GenerateStagedPrimaries(G4Event *event, const Bunch &bunch);
+  G4PrimaryVertex *CreateVertex(G4ParticleDefinition *particle,
+                                G4int n) const;
+  void ClearPendingBatches();
+
   G4ParticleGun *fParticleGun = nullptr;
+  const GunParameters *fParameters = nullptr;
+  const B4d::PhaseSpaceParameters *fPhaseSpaceParameters = nullptr;
+  const B4d::StackingParameters *fStackingParameters = nullptr;
+  // primary vertices of the batches not released yet, owned until they
+  // are added to the event
+  std::vector<std::vector<G4PrimaryVertex *>> fPendingBatches;
+  std::size_t fNextBatch = 0;
+  G4bool fStagingRefused = false; // warning issued
 };
 
 } // namespace B4
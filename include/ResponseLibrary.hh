@@ -0,0 +1,101 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/ResponseLibrary.hh
+/// \brief Definition of the B4d::ResponseLibrary class
+
+#ifndef B4dResponseLibrary_h
+#define B4dResponseLibrary_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+namespace B4d {
+
+/// Detector response library, used on the master only
+///
+/// In the single species mode (/B4/gun/species e+, pi+ or proton), each
+/// event is one primary. At the end of run, the mean and the covariance of
+/// the detector record (Gap ... GapN, TargetDet, NDet) per primary are added
+/// to the library, keyed by the species and the momentum, and the library
+/// is saved in a text file; the runs with the same key are pooled.
+/// The library is made for one detector setup, the ring layout, shell and
+/// ring scorer, and one list of detectors: the run of another setup is
+/// refused, so is a run of less than 2 events.
+///
+/// As the primaries of a bunch are independent, the response of a bunch of
+/// n_s primaries of each species s is predicted without any simulation:
+///   mean = sum_s n_s mean_s,  covariance = sum_s n_s covariance_s.
+/// This is done with /B4/response/combine, for any bunch composition.
+
+class ResponseLibrary {
+public:
+  static ResponseLibrary *Instance();
+
+  /// Set the library file; it is read at the next use
+  void SetFileName(const G4String &fileName);
+
+  /// Add the response of a run given the sums of the event records and of
+  /// their products (row-major), and save the library
+  void Add(const G4String &species, G4double momentum, const G4String &setup,
+           const std::vector<G4String> &detectorNames, G4int nofEvents,
+           const std::vector<G4double> &sums,
+           const std::vector<G4double> &products);
+
+  /// Print the predicted response of a bunch
+  void Combine(G4double momentum, G4int nofPositrons, G4int nofPions,
+               G4int nofProtons);
+
+private:
+  ResponseLibrary() = default;
+
+  // response per primary
+  struct Response {
+    G4String species;
+    G4double momentum = 0.;
+    G4int nofEvents = 0;
+    std::vector<G4double> mean;
+    std::vector<G4double> covariance; // row-major
+  };
+
+  Response *Find(const G4String &species, G4double momentum);
+  void Load();
+  void Save() const;
+
+  G4String fFileName = "B4_response.txt";
+  G4bool fIsLoaded = false;
+  G4String fSetup;
+  std::vector<G4String> fDetectorNames;
+  std::vector<Response> fResponses;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,88 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/RingSD.hh
+/// \brief Definition of the B4d::RingSD class
+
+#ifndef B4dRingSD_h
+#define B4dRingSD_h 1
+
+#include "G4VSensitiveDetector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4ParticleDefinition;
+
+namespace B4d {
+
+class Run;
+
+/// Detector ring sensitive detector class
+///
+/// A single sensitive detector shared by all detectors of the ring. It counts
+/// the neutrons entering a detector (as a weighted G4PSTrackCounter with
+/// fCurrent_In and a neutron filter) in a flat per-thread array indexed by
+/// the detector copy number: the counts are the sums of the track weights,
+/// which differ from 1 with the biasing of the SteppingAction. No hits
+/// collection is created: the counts are reset in Initialize() and read
+/// directly by the EventAction at the end of event.
+/// The array is sized when the geometry is (re)built, never during events.
+/// The kinetic energy and time of flight of the counted neutrons are also
+/// filled in the spectra of the Run, and the counts are added in the Run
+/// per species of the primary they descend from (see TrackInformation).
+
+class RingSD : public G4VSensitiveDetector {
+public:
+  RingSD(const G4String &name, G4int nofDetectors);
+  ~RingSD() override = default;
+
+  void Initialize(G4HCofThisEvent *hce) override;
+  G4bool ProcessHits(G4Step *step, G4TouchableHistory *history) override;
+
+  void SetNofDetectors(G4int nofDetectors);
+  const std::vector<G4double> &GetCounts() const;
+
+  /// Detector names used in the outputs: Gap, Gap2, Gap3, ...
+  static G4String GetDetectorName(G4int copyNo);
+
+private:
+  std::vector<G4double> fCounts;
+  const G4ParticleDefinition *fNeutron = nullptr;
+  Run *fRun = nullptr;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline const std::vector<G4double> &RingSD::GetCounts() const {
+  return fCounts;
+}
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
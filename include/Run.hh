@@ -0,0 +1,273 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/Run.hh
+/// \brief Definition of the B4d::Run class
+
+#ifndef B4dRun_h
+#define B4dRun_h 1
+
+#include "G4Run.hh"
+#include "LambertianApproximation.hh"
+#include "Spectra.hh"
+#include "StepProfile.hh"
+#include "globals.hh"
+
+#include <array>
+#include <vector>
+
+class G4Event;
+class G4Step;
+class G4ParticleDefinition;
+
+namespace B4d {
+
+/// Run class
+///
+/// It collects the per-thread run statistics of the user actions and merges
+/// them on the master at the end of the run:
+/// - number and kinetic energy of the tracks killed by the StackingAction,
+///   and of those killed in the kill zone of the SteppingAction, per
+///   particle species
+/// - neutron counts in the detectors of the ring, with their statistical
+///   errors, and their Lambertian approximation, printed apart as it is not
+///   an estimate of the counts (see LambertianApproximation)
+/// - neutron counts in the detectors of the ring per species of the primary
+///   they descend from (see TrackInformation)
+/// - peak depth of the track stack per event, and number of steps
+/// - kinetic energy and time of flight spectra of the neutrons entering the
+///   ring detectors and NDet (see Spectra)
+/// - sums of the event records and of their products in the single
+///   species mode (see ResponseLibrary)
+/// - number of neutrons split and rouletted by the biasing of the
+///   SteppingAction
+/// - number and energy of the showers parameterized by the
+///   TargetShowerModel, and number of neutrons it produced
+/// - number and time of the steps per particle, volume and creator process,
+///   with the profiling (see StepProfile)
+
+class Run : public G4Run {
+public:
+  /// Particle species used to classify the run statistics
+  enum Species {
+    kGamma,
+    kElectron,
+    kPositron,
+    kNeutron,
+    kProton,
+    kPion,
+    kOther,
+    kNofSpecies
+  };
+
+  /// Reasons for killing a track in the kill zone
+  enum KillReason { kOutsideEnvelope, kTimeCut, kEnergyCut, kNofKillReasons };
+
+  /// Spectra index of NDet (the spectra of the ring detectors are indexed
+  /// by their copy number)
+  static constexpr G4int kNDetSpectrum = -1;
+
+  Run() = default;
+  ~Run() override = default;
+
+  void RecordEvent(const G4Event *event) override;
+  void Merge(const G4Run *run) override;
+
+  static G4int GetSpecies(const G4ParticleDefinition *particle);
+  static const char *GetSpeciesName(G4int species);
+
+  /// Relative error of a sum of n event values, given the sum of their
+  /// squares
+  static G4double GetRelativeError(G4double sum, G4double sum2, G4int n);
+
+  void AddKilledTrack(G4int species, G4double kinEnergy);
+  void AddZoneKilledTrack(G4int species, G4int reason, G4double kinEnergy);
+
+  void AddRingCounts(const std::vector<G4double> &counts);
+  void BookOriginCounts(G4int nofRingDetectors);
+  void AddOriginCount(G4int detector, G4int species, G4double weight);
+  void AddResponse(const std::vector<G4double> &record);
+
+  void SetLambertianApproximation(
+      const LambertianApproximation &approximation);
+  void ScoreLambertian(const G4ThreeVector &position,
+                       const G4ThreeVector &normal, G4double weight);
+
+  void AddFastShower(G4double energy, G4int nofNeutrons);
+  void AddSplitTracks(G4int n) { fNofSplitTracks += n; }
+  void AddRouletteTrack(G4bool survived);
+
+  void SetStackDepth(G4int depth, G4int urgentDepth);
+  void AddStep() { ++fNofSteps; }
+  void StartTrackProfile() { fStepProfile.StartTrack(); }
+  void ProfileStep(const G4Step *step) { fStepProfile.AddStep(step); }
+
+  void BookSpectra(G4int nofRingDetectors);
+  void FillSpectra(G4int detector, G4double kinEnergy, G4double time,
+                   G4double weight);
+
+  G4int GetNofKilledTracks() const;
+  G4int GetNofZoneKilledTracks() const;
+  G4long GetNofSteps() const { return fNofSteps; }
+  G4int GetNofFastShowers() const { return fNofFastShowers; }
+  G4bool IsBiased() const;
+  G4int GetNofResponses() const { return fNofResponses; }
+  const std::vector<G4double> &GetResponseSums() const {
+    return fResponseSums;
+  }
+  const std::vector<G4double> &GetResponseProducts() const {
+    return fResponseProducts;
+  }
+  const std::vector<G4double> &GetRingCounts() const { return fRingCounts; }
+  const std::vector<G4double> &GetRingCounts2() const { return fRingCounts2; }
+  void PrintStackingStatistics() const;
+  void PrintKillZoneStatistics() const;
+  void PrintRingCounts() const;
+  void PrintOriginCounts() const;
+  void PrintStackDepth() const;
+  void PrintFastShowerStatistics() const;
+  void PrintBiasingStatistics() const;
+  void WriteSpectra(const G4String &fileName) const;
+  void PrintStepProfile() const;
+  void WriteStepProfile(const G4String &fileName) const;
+
+private:
+  std::array<G4int, kNofSpecies> fKilledTracks{};
+  std::array<G4double, kNofSpecies> fKilledEnergy{};
+  std::array<G4int, kNofSpecies> fZoneKilledTracks{};
+  std::array<G4double, kNofSpecies> fZoneKilledEnergy{};
+  std::array<G4int, kNofKillReasons> fZoneKillReasons{};
+  std::vector<G4double> fRingCounts;
+  std::vector<G4double> fRingCounts2; // sums of squares
+  std::vector<G4double> fOriginCounts; // [detector][origin species]
+  LambertianApproximation fLambertian;
+  std::vector<G4double> fLambertianScores; // current event
+  std::vector<G4double> fLambertianSums;
+  G4int fEventPeakStackDepth = 0; // current event
+  G4int fMaxPeakStackDepth = 0;
+  G4double fSumPeakStackDepth = 0.;
+  G4int fEventPeakUrgentDepth = 0; // urgent stack only
+  G4int fMaxPeakUrgentDepth = 0;
+  G4double fSumPeakUrgentDepth = 0.;
+  G4long fNofSteps = 0;
+  G4int fNofFastShowers = 0;
+  G4double fFastShowerEnergy = 0.;
+  G4int fNofFastNeutrons = 0;
+  G4int fNofResponses = 0;
+  std::vector<G4double> fResponseSums;
+  std::vector<G4double> fResponseProducts; // row-major
+  G4int fNofSplitTracks = 0;  // copies added
+  G4int fNofRouletteSurvived = 0;
+  G4int fNofRouletteKilled = 0;
+  Spectra fSpectra; // ring detectors, then NDet
+  StepProfile fStepProfile;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void Run::AddKilledTrack(G4int species, G4double kinEnergy) {
+  ++fKilledTracks[species];
+  fKilledEnergy[species] += kinEnergy;
+}
+
+inline void Run::AddZoneKilledTrack(G4int species, G4int reason,
+                                    G4double kinEnergy) {
+  ++fZoneKilledTracks[species];
+  fZoneKilledEnergy[species] += kinEnergy;
+  ++fZoneKillReasons[reason];
+}
+
+inline void Run::AddRingCounts(const std::vector<G4double> &counts) {
+  if (fRingCounts.size() < counts.size()) {
+    fRingCounts.resize(counts.size());
+    fRingCounts2.resize(counts.size());
+  }
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    fRingCounts[i] += counts[i];
+    fRingCounts2[i] += counts[i] * counts[i];
+  }
+}
+
+inline void Run::AddFastShower(G4double energy, G4int nofNeutrons) {
+  ++fNofFastShowers;
+  fFastShowerEnergy += energy;
+  fNofFastNeutrons += nofNeutrons;
+}
+
+inline void Run::AddRouletteTrack(G4bool survived) {
+  if (survived) {
+    ++fNofRouletteSurvived;
+  } else {
+    ++fNofRouletteKilled;
+  }
+}
+
+inline G4bool Run::IsBiased() const {
+  return fNofSplitTracks + fNofRouletteSurvived + fNofRouletteKilled > 0;
+}
+
+inline void Run::AddResponse(const std::vector<G4double> &record) {
+  auto n = record.size();
+  if (fResponseSums.size() != n) {
+    fResponseSums.assign(n, 0.);
+    fResponseProducts.assign(n * n, 0.);
+  }
+  ++fNofResponses;
+  for (std::size_t i = 0; i < n; ++i) {
+    fResponseSums[i] += record[i];
+    for (std::size_t j = 0; j < n; ++j) {
+      fResponseProducts[i * n + j] += record[i] * record[j];
+    }
+  }
+}
+
+inline void Run::AddOriginCount(G4int detector, G4int species,
+                                G4double weight) {
+  fOriginCounts[detector * kNofSpecies + species] += weight;
+}
+
+inline void Run::SetStackDepth(G4int depth, G4int urgentDepth) {
+  if (depth > fEventPeakStackDepth) fEventPeakStackDepth = depth;
+  if (urgentDepth > fEventPeakUrgentDepth) fEventPeakUrgentDepth = urgentDepth;
+}
+
+inline void Run::FillSpectra(G4int detector, G4double kinEnergy,
+                             G4double time, G4double weight) {
+  if (detector == kNDetSpectrum) detector = fSpectra.GetNofDetectors() - 1;
+  fSpectra.Fill(detector, kinEnergy, time, weight);
+}
+
+inline void Run::ScoreLambertian(const G4ThreeVector &position,
+                                 const G4ThreeVector &normal,
+                                 G4double weight) {
+  fLambertian.Score(position, normal, weight, fLambertianScores.data());
+}
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
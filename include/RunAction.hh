@@ -30,40 +30,109 @@
 #ifndef B4RunAction_h
 #define B4RunAction_h 1
 
+#include "G4Timer.hh"
 #include "G4UserRunAction.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class G4Run;
 
+namespace B4d {
+class EventAction;
+class Run;
+struct ConvergenceParameters;
+struct PhaseSpaceParameters;
+}
+
 namespace B4
 {
 
+struct GunParameters;
+
 /// Run action class
 ///
-/// It accumulates statistic and computes dispersion of the energy deposit
-/// and track lengths of charged particles with use of analysis tools:
-/// H1D histograms are created in BeginOfRunAction() for the following
-/// physics quantities:
-/// - Edep in absorber
-/// - Edep in gap
-/// - Track length in absorber
-/// - Track length in gap
-/// The same values are also saved in the ntuple.
+/// It books the analysis objects in the constructor:
+/// - the H1D histogram TCount of the neutron counts in Gap
+/// - the ntuple B4 with one row per event (or per bunch): TCount and the
+///   vector column Detectors with the record of all the detectors
+///   (Gap ... GapN, TargetDet, NDet), bound to the EventAction record
 /// The histograms and ntuple are saved in the output file in a format
-/// according to a specified file extension.
+/// according to a specified file extension. The file is B4.root by default
+/// and can be renamed with /analysis/setFileName, eg. per configuration of
+/// a scan; the neutron spectra file follows it (B4_spectra.csv).
 ///
 /// In EndOfRunAction(), the accumulated statistic and computed
 /// dispersion is printed.
 ///
+/// The run statistics of the user actions are collected in B4d::Run.
+/// On the master, the CPU time of the run is measured and, when tracks were
+/// killed by the stacking action or in the kill zone, compared with the CPU
+/// time per event of the last run without any track killing.
+///
+/// In the stage 1 of the two-stage simulation, the master opens the phase
+/// space file at the beginning of run and closes it at the end of run,
+/// after the workers have flushed their records. In the stage 2, it loads
+/// the input file at the beginning of run.
+///
+/// The memory of the process is reported too: the resident set size at
+/// the beginning of run and its peak during the run (Linux only). The
+/// threads share the memory of the process, so only its total growth is
+/// reported, with the number of threads.
+///
+/// With the fast shower model, the ring counts per event and the CPU time
+/// per event of the last run with the full simulation are kept, and
+/// compared with those of the runs with /B4/fast/validate true. With this
+/// command, a process without the fast simulation physics (no -f option)
+/// also writes them to B4_fullSimulation.txt, which is then the reference
+/// of the processes with it, as their full simulation pays for the fast
+/// simulation process. The file and the last run record their setup (the
+/// primaries, the ring layout, the shell and the ring scorer): a reference
+/// with another setup or another number of ring detectors is refused, and
+/// the reference used is printed.
+///
+/// The figure of merit 1/(relative error^2 * CPU time) of the ring counts
+/// is printed per detector; for the runs with the neutron biasing, it is
+/// compared with the one of the last analog run.
+///
+/// In the single species mode, the master adds the response per primary
+/// of the run to the ResponseLibrary.
+///
+/// The master also starts the ConvergenceMonitor with the names of the
+/// detectors in the order of the event records: Gap ... GapN, TargetDet
+/// and NDet.
+///
 
 class RunAction : public G4UserRunAction
 {
   public:
-    RunAction();
+    RunAction(const GunParameters* gunParameters,
+              const B4d::PhaseSpaceParameters* phaseSpaceParameters,
+              const B4d::ConvergenceParameters* convergenceParameters,
+              B4d::EventAction* eventAction = nullptr);
     ~RunAction() override = default;
 
+    G4Run* GenerateRun() override;
     void BeginOfRunAction(const G4Run*) override;
     void   EndOfRunAction(const G4Run*) override;
+
+  private:
+    void ValidateFastShowers(const B4d::Run* run, G4double timePerEvent);
+    void PrintFigureOfMerit(const B4d::Run* run, G4double cpuTime);
+
+    const GunParameters* fGunParameters = nullptr;
+    const B4d::PhaseSpaceParameters* fPhaseSpaceParameters = nullptr;
+    const B4d::ConvergenceParameters* fConvergenceParameters = nullptr;
+    G4Timer fTimer;
+    G4double fReferenceTimePerEvent = 0.; // without track killing
+    G4double fMemoryAtBegin = 0.; // MB
+    // last run with the full simulation of the showers
+    G4String fFullSetup; // primaries and ring setup
+    std::vector<G4double> fFullRingMeans; // per event
+    std::vector<G4double> fFullRingErrors;
+    G4double fFullTimePerEvent = 0.;
+    std::vector<G4double> fAnalogFigureOfMerit; // last run without biasing
+    std::vector<G4double> fRecord; // ntuple column buffer on the master
 };
 
 }
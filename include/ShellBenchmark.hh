@@ -0,0 +1,88 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/ShellBenchmark.hh
+/// \brief Definition of the B4d::ShellBenchmark class
+
+#ifndef B4dShellBenchmark_h
+#define B4dShellBenchmark_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4VSolid;
+
+namespace B4d {
+
+/// Geometry micro-benchmark of the NDet shell constructions
+///
+/// The three constructions selectable with /B4/det/shell are built as
+/// standalone solids, and the queries of the navigator are timed on each
+/// of them at the same random points and directions: Inside(), then
+/// DistanceToIn(p,v) or DistanceToOut(p,v), for each solid the navigator
+/// tests (the hollow box; the box and its cavity; the six slabs).
+/// Rays from the same points are then traced through the current geometry
+/// with a private G4Navigator, which gives the navigation steps per second
+/// of the full setup.
+///
+/// It is run with /B4/det/benchmarkShell N once the geometry is built; after
+/// a geometry command, the new geometry must first be built with a run.
+/// The points are generated with a local random engine, so that the run
+/// random numbers are not affected.
+
+class ShellBenchmark {
+public:
+  ShellBenchmark(G4double outerHalfLength, G4double innerHalfLength);
+  ~ShellBenchmark();
+
+  void Run(G4int nofPoints) const;
+
+private:
+  // solids of one shell construction, with their positions
+  struct Shell {
+    G4String name;
+    std::vector<G4VSolid *> solids;
+    std::vector<G4ThreeVector> positions;
+  };
+
+  void TimeSolids(const Shell &shell,
+                  const std::vector<G4ThreeVector> &points,
+                  const std::vector<G4ThreeVector> &directions) const;
+  void TimeNavigation(const std::vector<G4ThreeVector> &points,
+                      const std::vector<G4ThreeVector> &directions) const;
+
+  G4double fOuterHalfLength = 0.;
+  std::vector<Shell> fShells;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
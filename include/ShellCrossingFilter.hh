@@ -0,0 +1,74 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/ShellCrossingFilter.hh
+/// \brief Definition of the B4d::ShellCrossingFilter class
+
+#ifndef B4dShellCrossingFilter_h
+#define B4dShellCrossingFilter_h 1
+
+#include "G4VSDFilter.hh"
+#include "globals.hh"
+
+namespace B4d {
+
+/// Filter of the NDet primitive scorers, which hides the boundaries between
+/// the volumes of one sensitive detector (the six slabs of the NDet shell)
+///
+/// A step which ends on such a boundary and the steps which continue it in
+/// the next volume are seen as one step, as in the single solid of the other
+/// shell constructions:
+/// - kCrossing accepts the last step of the chain if the chain enters or
+///   leaves the detector (for a G4PSTrackCounter with fCurrent_InOut),
+/// - kEntry accepts the first step of the chain if it enters the detector
+///   (for a scorer of the entering tracks, as SpectrumScorer).
+/// The chain of the current track is kept in the filter, so that each
+/// primitive scorer has its own filter instance.
+
+class ShellCrossingFilter : public G4VSDFilter {
+public:
+  enum Mode { kCrossing, kEntry };
+
+  ShellCrossingFilter(const G4String &name, Mode mode);
+  ~ShellCrossingFilter() override = default;
+
+  G4bool Accept(const G4Step *step) const override;
+
+private:
+  Mode fMode = kCrossing;
+
+  // the step of the track which ended on an internal boundary, and whether
+  // its chain entered the detector
+  mutable G4int fTrackID = -1;
+  mutable G4int fStepNumber = -1;
+  mutable G4bool fEntered = false;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,110 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/Spectra.hh
+/// \brief Definition of the B4d::Spectra class
+
+#ifndef B4dSpectra_h
+#define B4dSpectra_h 1
+
+#include "G4SystemOfUnits.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace B4d {
+
+/// Neutron spectra of the detectors
+///
+/// For each detector, the kinetic energy (log bins, 10 per decade from
+/// 1 keV to 10 GeV) and the time of flight since the start of the event
+/// (5 ns bins up to 2 us) of the entering neutrons are histogrammed, with
+/// an underflow and an overflow bin each. The bins of all the detectors are
+/// stored in flat arrays, allocated once per run in Book(): Fill() computes
+/// the bin directly and neither locks nor allocates, the spectra being
+/// filled per thread in the Run and added at the end of run in Merge().
+
+class Spectra {
+public:
+  Spectra() = default;
+  ~Spectra() = default;
+
+  void Book(G4int nofDetectors);
+  void Fill(G4int detector, G4double kinEnergy, G4double time,
+            G4double weight);
+  void Merge(const Spectra &other);
+
+  /// Write the spectra in a CSV file, one line per bin
+  void Write(const G4String &fileName,
+             const std::vector<G4String> &detectorNames) const;
+
+  G4int GetNofDetectors() const { return fNofDetectors; }
+
+private:
+  static constexpr G4double kEnergyMin = 1. * keV;
+  static constexpr G4int kEnergyBinsPerDecade = 10;
+  static constexpr G4int kNofEnergyBins = 7 * kEnergyBinsPerDecade;
+  static constexpr G4double kTimeBinWidth = 5. * ns;
+  static constexpr G4int kNofTimeBins = 400;
+  // bins including the underflow (0) and the overflow (nofBins + 1)
+  static constexpr G4int kNofEnergyCells = kNofEnergyBins + 2;
+  static constexpr G4int kNofTimeCells = kNofTimeBins + 2;
+
+  static G4int GetEnergyCell(G4double kinEnergy);
+  static G4int GetTimeCell(G4double time);
+
+  G4int fNofDetectors = 0;
+  std::vector<G4double> fEnergy; // [detector][energy cell]
+  std::vector<G4double> fTime;   // [detector][time cell]
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline G4int Spectra::GetEnergyCell(G4double kinEnergy) {
+  if (kinEnergy <= 0.) return 0;
+  auto x = std::log10(kinEnergy / kEnergyMin) * kEnergyBinsPerDecade;
+  return std::clamp(G4int(std::floor(x)) + 1, 0, kNofEnergyBins + 1);
+}
+
+inline G4int Spectra::GetTimeCell(G4double time) {
+  if (time < 0.) return 0;
+  auto x = time / kTimeBinWidth;
+  return (x < kNofTimeBins) ? G4int(x) + 1 : kNofTimeBins + 1;
+}
+
+inline void Spectra::Fill(G4int detector, G4double kinEnergy, G4double time,
+                          G4double weight) {
+  fEnergy[detector * kNofEnergyCells + GetEnergyCell(kinEnergy)] += weight;
+  fTime[detector * kNofTimeCells + GetTimeCell(time)] += weight;
+}
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,66 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/SpectrumScorer.hh
+/// \brief Definition of the B4d::SpectrumScorer class
+
+#ifndef B4dSpectrumScorer_h
+#define B4dSpectrumScorer_h 1
+
+#include "G4VPrimitiveScorer.hh"
+#include "globals.hh"
+
+namespace B4d {
+
+class Run;
+
+/// Spectrum primitive scorer class
+///
+/// It fills the neutron spectra of the Run with the tracks entering the
+/// volume of its G4MultiFunctionalDetector (the filter of the detector
+/// selects the neutrons) in the given spectrum of the Run: the index of a
+/// ring detector or Run::kNDetSpectrum. No hits collection is filled.
+
+class SpectrumScorer : public G4VPrimitiveScorer {
+public:
+  SpectrumScorer(const G4String &name, G4int spectrum);
+  ~SpectrumScorer() override = default;
+
+  void Initialize(G4HCofThisEvent *hce) override;
+
+protected:
+  G4bool ProcessHits(G4Step *step, G4TouchableHistory *history) override;
+
+private:
+  G4int fSpectrum = 0;
+  Run *fRun = nullptr;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
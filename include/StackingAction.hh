@@ -0,0 +1,100 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/StackingAction.hh
+/// \brief Definition of the B4d::StackingAction class
+
+#ifndef B4dStackingAction_h
+#define B4dStackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+class G4LogicalVolume;
+
+namespace B4 {
+class PrimaryGeneratorAction;
+}
+
+namespace B4d {
+
+class Run;
+
+/// Stacking action parameters.
+/// They are set via the /B4/stack/ commands defined in ActionInitialization
+/// and shared (read-only) by the stacking actions of all threads.
+
+struct StackingParameters {
+  G4double emKillThreshold = 0.; // kill e-, e+, gamma below this energy
+  G4bool killOutsideTarget = false;
+  G4int primariesPerStage = 0; // staged primary injection (0 = off)
+};
+
+/// Stacking action class
+///
+/// Only neutrons are scored, so most of the CPU spent in the electromagnetic
+/// shower of the target is wasted. In ClassifyNewTrack() the secondary
+/// tracks are killed if:
+/// - they are e-, e+ or gamma with a kinetic energy below the EM kill
+///   threshold (eg. below the giant dipole photonuclear threshold,
+///   ~7 MeV in lead, they cannot produce neutrons any more);
+/// - they are not neutrons and are created outside the Target; the rest of
+///   the setup is vacuum, so these tracks can neither produce nor carry
+///   neutrons.
+///
+/// The number and the energy of the killed tracks are accumulated in Run.
+///
+/// With the staged primary injection, the primary generator action
+/// adds only the first batch of primariesPerStage primaries to the event.
+/// When the urgent stack is empty, NewStage() asks it to release the next
+/// batch, whose primary vertices are then added to the event, and stacks
+/// their tracks: the later tracks do not exist before, so that the stack
+/// holds at most one batch and its cascades at a time.
+/// The peak depths of the whole stack and of the urgent stack of each event
+/// are recorded in Run.
+
+class StackingAction : public G4UserStackingAction {
+public:
+  StackingAction(const StackingParameters *parameters,
+                 B4::PrimaryGeneratorAction *primaryGenerator);
+  ~StackingAction() override = default;
+
+  G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track *track) override;
+  void NewStage() override;
+  void PrepareNewEvent() override;
+
+private:
+  const StackingParameters *fParameters = nullptr;
+  B4::PrimaryGeneratorAction *fPrimaryGenerator = nullptr;
+  const G4LogicalVolume *fTargetLV = nullptr;
+  Run *fRun = nullptr;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,104 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/StartupProfiler.hh
+/// \brief Definition of the B4d::StartupProfiler class
+
+#ifndef B4dStartupProfiler_h
+#define B4dStartupProfiler_h 1
+
+#include "G4Threading.hh"
+#include "G4VStateDependent.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <vector>
+
+namespace B4d {
+
+/// Timing of the job startup, on the master
+///
+/// The startup is split in phases by the changes of the application state
+/// and by the marks of the DetectorConstruction:
+/// - job setup: from the construction to /run/initialize,
+/// - geometry: DetectorConstruction::Construct(), with the material print
+///   and the overlap checks if enabled,
+/// - sensitive detectors and fields: ConstructSDandField(),
+/// - parallel worlds and physics construction, until /run/initialize ends,
+/// - UI commands, until a run starts,
+/// - physics tables: the first run initialization, where the tables are
+///   built or retrieved from the PhysicsTableCache (in multi-threaded mode,
+///   it is done by /run/initialize, followed by the worker threads start),
+/// - first event: until the end of the first event of any thread.
+/// The real and CPU times of each phase are printed at the end of the first
+/// event, or at the end of the job if no event was processed.
+///
+/// The profiler is created first in main(); it is then available with
+/// Instance().
+
+class StartupProfiler : public G4VStateDependent {
+public:
+  StartupProfiler();
+  ~StartupProfiler() override;
+
+  static StartupProfiler *Instance() { return fInstance; }
+
+  G4bool Notify(G4ApplicationState requestedState) override;
+
+  /// End a phase of /run/initialize, on the master; ignored afterwards
+  void Mark(const G4String &name);
+  /// Called at the end of each event, on any thread
+  void EndOfEvent();
+
+private:
+  struct Phase {
+    G4String name;
+    G4double realTime = 0.;
+    G4double cpuTime = 0.;
+  };
+
+  void EndPhase(const G4String &name);
+  void Print() const;
+
+  static StartupProfiler *fInstance;
+
+  std::vector<Phase> fPhases;
+  std::chrono::steady_clock::time_point fStartTime;
+  std::clock_t fStartClock = 0;
+  G4bool fIsPhysicsConstructed = false;
+  G4bool fIsTableBuilt = false;
+  std::atomic<G4bool> fIsDone = false;
+  G4Mutex fMutex;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,121 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/StepProfile.hh
+/// \brief Definition of the B4d::StepProfile class
+
+#ifndef B4dStepProfile_h
+#define B4dStepProfile_h 1
+
+#include "globals.hh"
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4Step;
+class G4VProcess;
+
+namespace B4d {
+
+/// Profile of the stepping loop
+///
+/// The number of tracks and steps and the time spent are accumulated per
+/// particle species x logical volume (of the pre-step point) x creator
+/// process of the track ("primary" for the primaries). The time of a step
+/// is the real time of the thread since the previous step of the track,
+/// or since the track start for its first step; it includes the user
+/// actions, but not the stacking of the tracks between them. With one
+/// thread per core, it is the CPU time of the thread.
+///
+/// The entries are filled per thread, keyed by the pointers, without lock
+/// nor allocation once all the keys are seen; they are keyed by the names
+/// when added on the master in Merge(), the processes being thread-local.
+
+class StepProfile {
+public:
+  StepProfile() = default;
+  ~StepProfile() = default;
+
+  void StartTrack() { fLastTime = std::chrono::steady_clock::now(); }
+  void AddStep(const G4Step *step);
+  void Merge(const StepProfile &other);
+
+  G4bool IsEmpty() const { return fEntries.empty() && fNamedEntries.empty(); }
+
+  /// Print the entries with the largest times, with the totals per
+  /// species, volume and creator process
+  void Print(G4int nofRows) const;
+  /// Write all the entries in a CSV file
+  void Write(const G4String &fileName) const;
+
+private:
+  struct Entry {
+    G4long nofTracks = 0;
+    G4long nofSteps = 0;
+    G4double time = 0.; // s
+  };
+
+  struct Key {
+    const G4ParticleDefinition *particle = nullptr;
+    const G4LogicalVolume *volume = nullptr;
+    const G4VProcess *creator = nullptr;
+    G4bool operator==(const Key &other) const {
+      return particle == other.particle && volume == other.volume &&
+             creator == other.creator;
+    }
+  };
+
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      std::hash<const void *> hash;
+      return hash(key.particle) ^ (hash(key.volume) << 1) ^
+             (hash(key.creator) << 2);
+    }
+  };
+
+  // particle, volume, creator process
+  using Names = std::array<G4String, 3>;
+  using NamedEntries = std::map<Names, Entry>;
+
+  static void Add(Entry &entry, const Entry &other);
+  NamedEntries GetNamedEntries() const;
+
+  std::chrono::steady_clock::time_point fLastTime;
+  std::unordered_map<Key, Entry, KeyHash> fEntries; // this thread
+  NamedEntries fNamedEntries;                       // merged
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,139 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/SteppingAction.hh
+/// \brief Definition of the B4d::SteppingAction class
+
+#ifndef B4dSteppingAction_h
+#define B4dSteppingAction_h 1
+
+#include "G4SystemOfUnits.hh"
+#include "G4TouchableHandle.hh"
+#include "G4UserSteppingAction.hh"
+#include "globals.hh"
+
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4Track;
+
+namespace B4d {
+
+class DetectorConstruction;
+struct PhaseSpaceParameters;
+
+/// Kill zone parameters.
+/// They are set via the /B4/kill/ commands defined in ActionInitialization
+/// and shared (read-only) by the stepping actions of all threads.
+
+struct KillParameters {
+  G4bool outsideEnvelope = false;  // kill the tracks leaving the NDet shell
+  G4double timeCut = 0.;           // kill after this global time (0 = off)
+  G4double energyCut = 0.;         // kill non-neutrons below (0 = off)
+  G4double neutronEnergyCut = 0.;  // kill neutrons below (0 = off)
+};
+
+/// Biasing parameters.
+/// They are set via the /B4/bias/ commands defined in ActionInitialization
+/// and shared (read-only) by the stepping actions of all threads.
+
+struct BiasingParameters {
+  G4bool enabled = false;             // weight window in the Target
+  G4int splitting = 5;                // importance toward the ring plane
+  G4double ringHalfAngle = 15. * deg; // angular half-width of the ring
+};
+
+/// Profiling parameters.
+/// They are set via the /B4/profile/ commands defined in ActionInitialization
+/// and shared (read-only) by the stepping and tracking actions of all
+/// threads.
+
+struct ProfileParameters {
+  G4bool enabled = false; // profile the stepping loop (see StepProfile)
+};
+
+/// Stepping action class
+///
+/// For each neutron leaving the Target, it scores the Lambertian
+/// approximation of the ring counts (see LambertianApproximation) in the
+/// Run.
+///
+/// In the stage 1 of the two-stage simulation, it writes the neutrons
+/// leaving the Target to the phase space file and optionally stops them.
+///
+/// With the biasing, a weight window is applied to the neutrons at their
+/// collisions in the Target, where they get their direction. The neutrons
+/// toward the ring plane (y = 0), within the ring half-angle, have the
+/// importance N and the target weight 1/N, the others the importance 1 and
+/// the target weight 1. A neutron with 2 times its target weight or more
+/// is split in copies of about the target weight, added to the secondaries
+/// of the step; a neutron with less than half of it is rouletted up to it.
+/// The neutrons created in the step are only split. The copies sample
+/// their next collisions in the lead independently; a split at the Target
+/// exit would only copy the same straight flight through the vacuum. The
+/// ring scorers add the weights, so that the counts are unbiased.
+///
+/// It also applies the kill zone: the tracks are stopped when they leave
+/// the outer surface of the NDet shell, which bounds all the scorers (the
+/// World around is vacuum, so without magnetic field they cannot come
+/// back), after the time cut, or below the energy cuts. The killed tracks
+/// are counted per species in the Run.
+///
+/// With the profiling, the number and time of the steps are added to the
+/// StepProfile of the Run.
+
+class SteppingAction : public G4UserSteppingAction {
+public:
+  SteppingAction(const PhaseSpaceParameters *phaseSpaceParameters,
+                 const KillParameters *killParameters,
+                 const BiasingParameters *biasingParameters,
+                 const ProfileParameters *profileParameters);
+  ~SteppingAction() override = default;
+
+  void UserSteppingAction(const G4Step *step) override;
+
+private:
+  G4bool IsTarget(const G4LogicalVolume *volume);
+  void ProcessTargetExit(const G4Step *step);
+  G4double GetTargetWeight(const G4Track *track) const;
+  void ApplyBiasing(const G4Step *step);
+  void Split(G4Track *track, G4int n, G4int parentID,
+             const G4TouchableHandle &touchable);
+  void ApplyKillZone(const G4Step *step);
+
+  const PhaseSpaceParameters *fPhaseSpaceParameters = nullptr;
+  const KillParameters *fKillParameters = nullptr;
+  const BiasingParameters *fBiasingParameters = nullptr;
+  const ProfileParameters *fProfileParameters = nullptr;
+  const DetectorConstruction *fDetector = nullptr;
+  const G4ParticleDefinition *fNeutron = nullptr;
+  const G4LogicalVolume *fTargetLV = nullptr;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,72 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/include/TargetParallelWorld.hh
+/// \brief Definition of the B4d::TargetParallelWorld class
+
+#ifndef B4dTargetParallelWorld_h
+#define B4dTargetParallelWorld_h 1
+
+#include "G4VUserParallelWorld.hh"
+#include "globals.hh"
+
+class G4LogicalVolume;
+
+namespace B4d {
+
+class DetectorConstruction;
+
+/// Parallel world of the target scoring volume
+///
+/// The TargetDet scoring volume (track length of the charged particles)
+/// is a copy of the Target solid, at the same position and rotation, placed
+/// in this parallel world: the mass geometry then has a single Target
+/// volume, without overlap. The world must be activated in the physics
+/// list with G4ParallelWorldPhysics.
+///
+/// With the -s overlap option of main(), the parallel world and its physics
+/// are not registered and TargetDet is placed in the mass geometry, as
+/// before, eg. to compare the two navigation costs.
+
+class TargetParallelWorld : public G4VUserParallelWorld {
+public:
+  TargetParallelWorld(const G4String &worldName,
+                      const DetectorConstruction *detector);
+  ~TargetParallelWorld() override = default;
+
+  void Construct() override;
+  void ConstructSD() override;
+
+private:
+  const DetectorConstruction *fDetector = nullptr;
+  G4LogicalVolume *fTargetDetLV = nullptr;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
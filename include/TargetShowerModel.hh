@@ -0,0 +1,94 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/TargetShowerModel.hh
+/// \brief Definition of the B4d::TargetShowerModel class
+
+#ifndef B4dTargetShowerModel_h
+#define B4dTargetShowerModel_h 1
+
+#include "G4SystemOfUnits.hh"
+#include "G4VFastSimulationModel.hh"
+#include "globals.hh"
+
+class G4ParticleDefinition;
+
+namespace B4d {
+
+/// Fast shower parameters.
+/// They are set via the /B4/fast/ commands defined in DetectorConstruction
+/// and shared (read-only) by the models of all threads.
+///
+/// The default neutron yield is the saturation yield of a thick lead
+/// target, about 2e12 n/s per kW of electron beam power; it can be
+/// calibrated with the validation mode.
+
+struct FastShowerParameters {
+  G4bool enabled = false;               // parameterize the EM showers
+  G4double energyThreshold = 100. * MeV; // minimum energy of the shower
+  G4double neutronYield = 0.32;         // mean number of neutrons per GeV
+  G4double temperature = 0.9 * MeV;     // evaporation spectrum temperature
+  G4bool validate = false; // compare the ring with the last full simulation
+};
+
+/// Fast simulation model of the e+, e- and gamma showers in the Target
+///
+/// The model is attached to the TargetRegion. When enabled, the e+, e- and
+/// gamma entering or created in the Target above the energy threshold are
+/// killed and their energy deposited locally; the neutrons of the
+/// photonuclear reactions of the shower are then produced:
+/// - their number is Poisson distributed, with a mean of the neutron yield
+///   times the shower energy,
+/// - their kinetic energy follows the evaporation spectrum
+///   E exp(-E/T), and their direction is isotropic,
+/// - they start at the depth of the shower maximum along the particle
+///   direction, X0 (ln(E/Ec) + C), limited by the Target surface.
+///
+/// The showers and the neutrons produced are counted in the Run.
+
+class TargetShowerModel : public G4VFastSimulationModel {
+public:
+  TargetShowerModel(const G4String &name, G4Region *region,
+                    const FastShowerParameters *parameters);
+  ~TargetShowerModel() override = default;
+
+  G4bool IsApplicable(const G4ParticleDefinition &particle) override;
+  G4bool ModelTrigger(const G4FastTrack &fastTrack) override;
+  void DoIt(const G4FastTrack &fastTrack, G4FastStep &fastStep) override;
+
+private:
+  G4double GetShowerMaxDepth(const G4FastTrack &fastTrack) const;
+
+  const FastShowerParameters *fParameters = nullptr;
+  const G4ParticleDefinition *fNeutron = nullptr;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,87 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/TrackInformation.hh
+/// \brief Definition of the B4d::TrackInformation class
+
+#ifndef B4dTrackInformation_h
+#define B4dTrackInformation_h 1
+
+#include "G4Allocator.hh"
+#include "G4VUserTrackInformation.hh"
+#include "globals.hh"
+
+namespace B4d {
+
+/// Track information class
+///
+/// It holds the ancestry of a track: the species of the primary it
+/// descends from (a Run::Species) and the index of this primary in the
+/// event. It is attached to the primaries and copied to their secondaries
+/// by the TrackingAction. The objects are allocated from a per-thread
+/// G4Allocator pool, so that the tagging does not allocate on the heap
+/// for each track.
+
+class TrackInformation : public G4VUserTrackInformation {
+public:
+  TrackInformation(G4int originSpecies, G4int primaryIndex);
+  TrackInformation(const TrackInformation &info) = default;
+  ~TrackInformation() override = default;
+
+  inline void *operator new(size_t);
+  inline void operator delete(void *info);
+
+  void Print() const override;
+
+  G4int GetOriginSpecies() const { return fOriginSpecies; }
+  G4int GetPrimaryIndex() const { return fPrimaryIndex; }
+
+private:
+  G4int fOriginSpecies = 0;
+  G4int fPrimaryIndex = 0;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+extern G4ThreadLocal G4Allocator<TrackInformation> *TrackInformationAllocator;
+
+inline void *TrackInformation::operator new(size_t) {
+  if (!TrackInformationAllocator) {
+    TrackInformationAllocator = new G4Allocator<TrackInformation>;
+  }
+  return (void *)TrackInformationAllocator->MallocSingle();
+}
+
+inline void TrackInformation::operator delete(void *info) {
+  TrackInformationAllocator->FreeSingle((TrackInformation *)info);
+}
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,67 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/TrackingAction.hh
+/// \brief Definition of the B4d::TrackingAction class
+
+#ifndef B4dTrackingAction_h
+#define B4dTrackingAction_h 1
+
+#include "G4UserTrackingAction.hh"
+#include "globals.hh"
+
+namespace B4d {
+
+struct ProfileParameters;
+
+/// Tracking action class
+///
+/// It tags the primaries with their TrackInformation (species and index
+/// of the primary, which is its track ID) and, at the end of each track,
+/// copies the information of the track to its secondaries, including the
+/// neutron copies of the biasing and the neutrons of the fast showers.
+///
+/// With the profiling, it starts the timing of each track in the
+/// StepProfile of the Run.
+
+class TrackingAction : public G4UserTrackingAction {
+public:
+  TrackingAction(const ProfileParameters *profileParameters);
+  ~TrackingAction() override = default;
+
+  void PreUserTrackingAction(const G4Track *track) override;
+  void PostUserTrackingAction(const G4Track *track) override;
+
+private:
+  const ProfileParameters *fProfileParameters = nullptr;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,83 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/WorkerInitialization.hh
+/// \brief Definition of the B4d::WorkerInitialization class
+
+#ifndef B4dWorkerInitialization_h
+#define B4dWorkerInitialization_h 1
+
+#include "G4UserWorkerInitialization.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace B4d {
+
+/// Worker thread initialization: pinning of the worker threads
+///
+/// With /B4/run/pinning (or -p in main()), each worker thread is pinned
+/// when it starts, before it builds its geometry and physics:
+/// - core: to one core, the workers taking the available cores in turn,
+/// - numa: to the cores of one NUMA node, the workers being spread over
+///   the nodes in turn,
+/// - none: not pinned (default).
+/// The memory of a worker (its copy of the physics data, eg. the Bertini
+/// cascade data, its events and hits) is allocated after the pinning, so
+/// that the default first-touch policy of Linux places it on the local
+/// node.
+///
+/// The available cores are those of the process affinity mask, which can
+/// be restricted with taskset or numactl; the mask and the NUMA nodes are
+/// read on the master. Pinning is available on Linux only; it replaces the
+/// Geant4 /run/pinAffinity, which should not be used together.
+
+class WorkerInitialization : public G4UserWorkerInitialization {
+public:
+  WorkerInitialization();
+  ~WorkerInitialization() override;
+
+  void WorkerInitialize() const override;
+
+  void SetPinning(const G4String &pinning) { fPinning = pinning; }
+
+private:
+  void DefineCommands();
+
+  G4String fPinning = "none";
+  std::vector<G4int> fCores;
+  std::vector<std::vector<G4int>> fNodes; // available cores per NUMA node
+  G4GenericMessenger *fMessenger = nullptr;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,92 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/include/WorkerTimeline.hh
+/// \brief Definition of the B4d::WorkerTimeline class
+
+#ifndef B4dWorkerTimeline_h
+#define B4dWorkerTimeline_h 1
+
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <chrono>
+#include <vector>
+
+namespace B4d {
+
+/// Timeline of the worker threads, shared by all threads.
+///
+/// The busy interval of each event (from BeginOfEventAction to
+/// EndOfEventAction) is recorded per thread, relative to the beginning of
+/// the run on the master. At the end of run, the master writes the
+/// timeline in a csv file (thread, event start, event end, in s) and
+/// prints the idle fraction of the threads, and its part in the tail of
+/// the run: the time between the last event of each thread and the end
+/// of the run.
+///
+/// The mean event time per thread is also used online by the
+/// AdaptiveRunManager to size the event chunks.
+
+class WorkerTimeline {
+public:
+  static WorkerTimeline *Instance();
+
+  /// Start a run, on the master
+  void Start(G4int nofThreads);
+
+  /// Time since the beginning of run (s)
+  G4double GetTime() const;
+
+  /// Add an event of the current thread, from its start time to now
+  void AddEvent(G4double startTime);
+
+  /// Mean event time per thread (s), 0 for the threads without event
+  std::vector<G4double> GetMeanEventTimes() const;
+
+  /// End the run: print the idle fractions and write the timeline
+  void Write(const G4String &fileName);
+
+private:
+  WorkerTimeline() = default;
+
+  struct Interval {
+    G4double start = 0.;
+    G4double end = 0.;
+  };
+
+  std::chrono::steady_clock::time_point fStartTime;
+  std::vector<std::vector<Interval>> fIntervals; // per thread
+  std::vector<G4double> fBusyTimes;              // per thread
+  mutable G4Mutex fMutex;
+};
+
+} // namespace B4d
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,32 @@
+#!/bin/sh
+# Scaling report of exampleB4d: events per second versus the number of
+# threads, from 1 to maxThreads, written in B4_scaling.csv
+#
+# usage: ./scaling.sh [maxThreads] [serial|mt|tasking|adaptive] [none|core|numa]
+#
+maxThreads=${1:-$(nproc)}
+runManager=${2:-mt}
+pinning=${3:-none}
+output=B4_scaling.csv
+
+echo "threads,events_per_s,speedup,efficiency" > $output
+rate1=
+threads=1
+while [ $threads -le $maxThreads ]; do
+  # event rate of the last (measured) run
+  rate=$(./exampleB4d -m scaling.mac -r $runManager -t $threads \
+           -p $pinning 2>/dev/null \
+         | awk '/ Event rate: / { rate = $3 } END { print rate }')
+  if [ -z "$rate" ]; then
+    echo "exampleB4d failed with $threads thread(s)" >&2
+    exit 1
+  fi
+  [ -z "$rate1" ] && rate1=$rate
+  echo "$threads $rate $rate1" \
+    | awk '{ printf "%d,%g,%.3f,%.3f\n", $1, $2, $2 / $3, $2 / $3 / $1 }' \
+    >> $output
+  threads=$((threads + 1))
+done
+
+echo " Scaling ($runManager, pinning $pinning):"
+column -s, -t $output 2>/dev/null || cat $output
@@ -28,9 +28,25 @@
 /// \brief Implementation of the B4d::ActionInitialization class
 
 #include "ActionInitialization.hh"
+#include "DetectorConstruction.hh"
 #include "PrimaryGeneratorAction.hh"
+#include "ResponseLibrary.hh"
 #include "RunAction.hh"
 #include "EventAction.hh"
+#include "StackingAction.hh"
+#include "SteppingAction.hh"
+#include "TrackingAction.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UImanager.hh"
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace B4;
 
@@ -39,18 +55,461 @@ namespace B4d
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+ActionInitialization::ActionInitialization()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ActionInitialization::~ActionInitialization()
+{
+  delete fStackMessenger;
+  delete fGunMessenger;
+  delete fPhaseSpaceMessenger;
+  delete fConvergenceMessenger;
+  delete fKillMessenger;
+  delete fBiasingMessenger;
+  delete fProfileMessenger;
+  delete fResponseMessenger;
+  delete fScanMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void ActionInitialization::BuildForMaster() const
 {
-  SetUserAction(new RunAction);
+  SetUserAction(new RunAction(&fGunParameters, &fPhaseSpaceParameters,
+                              &fConvergenceParameters));
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void ActionInitialization::Build() const
 {
-  SetUserAction(new PrimaryGeneratorAction);
-  SetUserAction(new RunAction);
-  SetUserAction(new EventAction);
+  auto primaryGenerator = new PrimaryGeneratorAction(
+    &fGunParameters, &fPhaseSpaceParameters, &fStackingParameters);
+  SetUserAction(primaryGenerator);
+  auto eventAction = new EventAction(&fGunParameters);
+  SetUserAction(new RunAction(&fGunParameters, &fPhaseSpaceParameters,
+                              &fConvergenceParameters, eventAction));
+  SetUserAction(eventAction);
+  SetUserAction(new StackingAction(&fStackingParameters, primaryGenerator));
+  SetUserAction(new TrackingAction(&fProfileParameters));
+  SetUserAction(new SteppingAction(&fPhaseSpaceParameters, &fKillParameters,
+                                   &fBiasingParameters, &fProfileParameters));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ActionInitialization::DefineCommands()
+{
+  // The parameters are read directly by the worker actions, so the commands
+  // are executed on the master only
+  fStackMessenger = new G4GenericMessenger(this, "/B4/stack/",
+                                           "Stacking action control");
+
+  auto& emKillCmd = fStackMessenger->DeclarePropertyWithUnit(
+    "emKillThreshold", "MeV", fStackingParameters.emKillThreshold,
+    "Kill secondary e-, e+ and gamma below this kinetic energy (0 = off).");
+  emKillCmd.SetParameterName("threshold", false);
+  emKillCmd.SetRange("threshold>=0.");
+  emKillCmd.SetStates(G4State_PreInit, G4State_Idle);
+  emKillCmd.SetToBeBroadcasted(false);
+
+  auto& outsideCmd = fStackMessenger->DeclareProperty(
+    "killOutsideTarget", fStackingParameters.killOutsideTarget,
+    "Kill secondaries other than neutrons created outside the Target.");
+  outsideCmd.SetParameterName("flag", false);
+  outsideCmd.SetStates(G4State_PreInit, G4State_Idle);
+  outsideCmd.SetToBeBroadcasted(false);
+
+  auto& stageCmd = fStackMessenger->DeclareProperty(
+    "primariesPerStage", fStackingParameters.primariesPerStage,
+    "Create the primaries by batches of N, the next batch when the\n"
+    "previous one is fully tracked (0 = all at once).");
+  stageCmd.SetParameterName("N", false);
+  stageCmd.SetRange("N>=0");
+  stageCmd.SetStates(G4State_PreInit, G4State_Idle);
+  stageCmd.SetToBeBroadcasted(false);
+
+  fGunMessenger =
+    new G4GenericMessenger(this, "/B4/gun/", "Primary generator control");
+
+  auto& chunksCmd = fGunMessenger->DeclareProperty(
+    "chunksPerBunch", fGunParameters.chunksPerBunch,
+    "Split each bunch in N events (sub-event mode), which can be tracked\n"
+    "on different threads; the number of bunches is beamOn / N.");
+  chunksCmd.SetParameterName("N", false);
+  chunksCmd.SetRange("N>=1");
+  chunksCmd.SetStates(G4State_PreInit, G4State_Idle);
+  chunksCmd.SetToBeBroadcasted(false);
+
+  auto& positronsCmd = fGunMessenger->DeclareProperty(
+    "positrons", fGunParameters.nofPositrons,
+    "Set the number of e+ per bunch.");
+  positronsCmd.SetParameterName("N", false);
+  positronsCmd.SetRange("N>=0");
+  positronsCmd.SetStates(G4State_PreInit, G4State_Idle);
+  positronsCmd.SetToBeBroadcasted(false);
+
+  auto& pionsCmd = fGunMessenger->DeclareProperty(
+    "pions", fGunParameters.nofPions,
+    "Set the number of pi+ per bunch.");
+  pionsCmd.SetParameterName("N", false);
+  pionsCmd.SetRange("N>=0");
+  pionsCmd.SetStates(G4State_PreInit, G4State_Idle);
+  pionsCmd.SetToBeBroadcasted(false);
+
+  auto& protonsCmd = fGunMessenger->DeclareProperty(
+    "protons", fGunParameters.nofProtons,
+    "Set the number of protons per bunch.");
+  protonsCmd.SetParameterName("N", false);
+  protonsCmd.SetRange("N>=0");
+  protonsCmd.SetStates(G4State_PreInit, G4State_Idle);
+  protonsCmd.SetToBeBroadcasted(false);
+
+  auto& gunNeutronsCmd = fGunMessenger->DeclareProperty(
+    "neutrons", fGunParameters.nofNeutrons,
+    "Set the number of neutrons per bunch (default 0).");
+  gunNeutronsCmd.SetParameterName("N", false);
+  gunNeutronsCmd.SetRange("N>=0");
+  gunNeutronsCmd.SetStates(G4State_PreInit, G4State_Idle);
+  gunNeutronsCmd.SetToBeBroadcasted(false);
+
+  auto& momentumCmd = fGunMessenger->DeclarePropertyWithUnit(
+    "momentum", "GeV", fGunParameters.momentum,
+    "Set the momentum of the primaries.");
+  momentumCmd.SetParameterName("momentum", false);
+  momentumCmd.SetRange("momentum>0.");
+  momentumCmd.SetStates(G4State_PreInit, G4State_Idle);
+  momentumCmd.SetToBeBroadcasted(false);
+
+  auto& speciesCmd = fGunMessenger->DeclareProperty(
+    "species", fGunParameters.species,
+    "Shoot the full bunch (default), or one primary of this species per\n"
+    "event to build the response library.");
+  speciesCmd.SetParameterName("species", false);
+  speciesCmd.SetCandidates("bunch e+ pi+ proton");
+  speciesCmd.SetStates(G4State_PreInit, G4State_Idle);
+  speciesCmd.SetToBeBroadcasted(false);
+
+  auto& eventSeedCmd = fGunMessenger->DeclareProperty(
+    "eventSeed", fGunParameters.eventSeed,
+    "Reseed each event from this seed and the event ID, for results\n"
+    "independent of the run manager and of the threads (0: off, default).");
+  eventSeedCmd.SetParameterName("seed", false);
+  eventSeedCmd.SetStates(G4State_PreInit, G4State_Idle);
+  eventSeedCmd.SetToBeBroadcasted(false);
+
+  fPhaseSpaceMessenger = new G4GenericMessenger(
+    this, "/B4/phsp/", "Two-stage simulation with a neutron phase space file");
+
+  auto& outputCmd = fPhaseSpaceMessenger->DeclareProperty(
+    "output", fPhaseSpaceParameters.outputFile,
+    "Stage 1: write the neutrons leaving the Target to this file\n"
+    "(\"\" = no output); the next runs of the job append to it.");
+  outputCmd.SetParameterName("fileName", true);
+  outputCmd.SetDefaultValue("");
+  outputCmd.SetStates(G4State_PreInit, G4State_Idle);
+  outputCmd.SetToBeBroadcasted(false);
+
+  auto& killCmd = fPhaseSpaceMessenger->DeclareProperty(
+    "killRecorded", fPhaseSpaceParameters.killRecorded,
+    "Stage 1: stop the neutrons once written to the phase space file.");
+  killCmd.SetParameterName("flag", false);
+  killCmd.SetStates(G4State_PreInit, G4State_Idle);
+  killCmd.SetToBeBroadcasted(false);
+
+  auto& inputCmd = fPhaseSpaceMessenger->DeclareProperty(
+    "input", fPhaseSpaceParameters.inputFile,
+    "Stage 2: generate the primary neutrons from this phase space file\n"
+    "(\"\" = bunch generator).");
+  inputCmd.SetParameterName("fileName", true);
+  inputCmd.SetDefaultValue("");
+  inputCmd.SetStates(G4State_PreInit, G4State_Idle);
+  inputCmd.SetToBeBroadcasted(false);
+
+  auto& modeCmd = fPhaseSpaceMessenger->DeclareProperty(
+    "mode", fPhaseSpaceParameters.mode,
+    "Stage 2: replay the file records in order or resample them at random.");
+  modeCmd.SetParameterName("mode", false);
+  modeCmd.SetCandidates("replay resample");
+  modeCmd.SetStates(G4State_PreInit, G4State_Idle);
+  modeCmd.SetToBeBroadcasted(false);
+
+  auto& neutronsCmd = fPhaseSpaceMessenger->DeclareProperty(
+    "neutronsPerEvent", fPhaseSpaceParameters.neutronsPerEvent,
+    "Stage 2: number of neutrons per event.");
+  neutronsCmd.SetParameterName("N", false);
+  neutronsCmd.SetRange("N>=1");
+  neutronsCmd.SetStates(G4State_PreInit, G4State_Idle);
+  neutronsCmd.SetToBeBroadcasted(false);
+
+  fConvergenceMessenger = new G4GenericMessenger(
+    this, "/B4/conv/", "Adaptive run length: /run/beamOn N is an upper limit");
+
+  auto& relErrorCmd = fConvergenceMessenger->DeclareProperty(
+    "relativeError", fConvergenceParameters.relativeError,
+    "Stop the run when the relative error of the total of each requested\n"
+    "detector is below this value (0 = off).");
+  relErrorCmd.SetParameterName("error", false);
+  relErrorCmd.SetRange("error>=0. && error<1.");
+  relErrorCmd.SetStates(G4State_PreInit, G4State_Idle);
+  relErrorCmd.SetToBeBroadcasted(false);
+
+  auto& budgetCmd = fConvergenceMessenger->DeclarePropertyWithUnit(
+    "timeBudget", "s", fConvergenceParameters.timeBudget,
+    "Stop the run when this wall time is exceeded (0 = no limit).");
+  budgetCmd.SetParameterName("time", false);
+  budgetCmd.SetRange("time>=0.");
+  budgetCmd.SetStates(G4State_PreInit, G4State_Idle);
+  budgetCmd.SetToBeBroadcasted(false);
+
+  auto& detectorsCmd = fConvergenceMessenger->DeclareProperty(
+    "detectors", fConvergenceParameters.detectors,
+    "Detectors which must reach the relative error: all, or a list of\n"
+    "Gap ... GapN, TargetDet and NDet.");
+  detectorsCmd.SetParameterName("names", false);
+  detectorsCmd.SetStates(G4State_PreInit, G4State_Idle);
+  detectorsCmd.SetToBeBroadcasted(false);
+
+  auto& minEventsCmd = fConvergenceMessenger->DeclareProperty(
+    "minEvents", fConvergenceParameters.minEvents,
+    "Minimum number of events (bunches) before the first check.");
+  minEventsCmd.SetParameterName("N", false);
+  minEventsCmd.SetRange("N>=2");
+  minEventsCmd.SetStates(G4State_PreInit, G4State_Idle);
+  minEventsCmd.SetToBeBroadcasted(false);
+
+  fKillMessenger =
+    new G4GenericMessenger(this, "/B4/kill/", "Kill zone control");
+
+  auto& envelopeCmd = fKillMessenger->DeclareProperty(
+    "outsideEnvelope", fKillParameters.outsideEnvelope,
+    "Kill the tracks leaving the outer surface of the NDet shell.");
+  envelopeCmd.SetParameterName("flag", false);
+  envelopeCmd.SetStates(G4State_PreInit, G4State_Idle);
+  envelopeCmd.SetToBeBroadcasted(false);
+
+  auto& timeCutCmd = fKillMessenger->DeclarePropertyWithUnit(
+    "timeCut", "ns", fKillParameters.timeCut,
+    "Kill the tracks after this global time (0 = off).");
+  timeCutCmd.SetParameterName("time", false);
+  timeCutCmd.SetRange("time>=0.");
+  timeCutCmd.SetStates(G4State_PreInit, G4State_Idle);
+  timeCutCmd.SetToBeBroadcasted(false);
+
+  auto& energyCutCmd = fKillMessenger->DeclarePropertyWithUnit(
+    "energyCut", "MeV", fKillParameters.energyCut,
+    "Kill the tracks other than neutrons below this kinetic energy\n"
+    "(0 = off).");
+  energyCutCmd.SetParameterName("energy", false);
+  energyCutCmd.SetRange("energy>=0.");
+  energyCutCmd.SetStates(G4State_PreInit, G4State_Idle);
+  energyCutCmd.SetToBeBroadcasted(false);
+
+  auto& neutronCutCmd = fKillMessenger->DeclarePropertyWithUnit(
+    "neutronEnergyCut", "MeV", fKillParameters.neutronEnergyCut,
+    "Kill the neutrons below this kinetic energy (0 = off).");
+  neutronCutCmd.SetParameterName("energy", false);
+  neutronCutCmd.SetRange("energy>=0.");
+  neutronCutCmd.SetStates(G4State_PreInit, G4State_Idle);
+  neutronCutCmd.SetToBeBroadcasted(false);
+
+  fBiasingMessenger = new G4GenericMessenger(
+    this, "/B4/bias/", "Neutron weight window in the Target");
+
+  auto& biasCmd = fBiasingMessenger->DeclareProperty(
+    "enable", fBiasingParameters.enabled,
+    "Split the neutrons toward the ring plane and roulette the others at\n"
+    "their collisions in the Target.");
+  biasCmd.SetParameterName("flag", false);
+  biasCmd.SetStates(G4State_PreInit, G4State_Idle);
+  biasCmd.SetToBeBroadcasted(false);
+
+  auto& splittingCmd = fBiasingMessenger->DeclareProperty(
+    "splitting", fBiasingParameters.splitting,
+    "Importance of the neutrons toward the ring plane: number of copies\n"
+    "of a neutron scattered toward it.");
+  splittingCmd.SetParameterName("N", false);
+  splittingCmd.SetRange("N>=1");
+  splittingCmd.SetStates(G4State_PreInit, G4State_Idle);
+  splittingCmd.SetToBeBroadcasted(false);
+
+  auto& halfAngleCmd = fBiasingMessenger->DeclarePropertyWithUnit(
+    "ringHalfAngle", "deg", fBiasingParameters.ringHalfAngle,
+    "Angular half-width of the ring: the neutrons within this angle of the\n"
+    "ring plane are split.");
+  halfAngleCmd.SetParameterName("angle", false);
+  halfAngleCmd.SetRange("angle>0. && angle<=90.");
+  halfAngleCmd.SetStates(G4State_PreInit, G4State_Idle);
+  halfAngleCmd.SetToBeBroadcasted(false);
+
+  fProfileMessenger = new G4GenericMessenger(
+    this, "/B4/profile/", "Profiling of the stepping loop");
+
+  auto& profileCmd = fProfileMessenger->DeclareProperty(
+    "enable", fProfileParameters.enabled,
+    "Accumulate the number and time of the steps per particle, volume and\n"
+    "creator process, printed and written in B4_profile.csv at the end of\n"
+    "run.");
+  profileCmd.SetParameterName("flag", false);
+  profileCmd.SetStates(G4State_PreInit, G4State_Idle);
+  profileCmd.SetToBeBroadcasted(false);
+
+  fResponseMessenger = new G4GenericMessenger(
+    this, "/B4/response/", "Detector response library per primary");
+
+  auto& fileCmd = fResponseMessenger->DeclareMethod(
+    "file", &ActionInitialization::SetResponseFile,
+    "Set the response library file (default B4_response.txt).");
+  fileCmd.SetParameterName("fileName", false);
+  fileCmd.SetStates(G4State_PreInit, G4State_Idle);
+  fileCmd.SetToBeBroadcasted(false);
+
+  auto& combineCmd = fResponseMessenger->DeclareMethod(
+    "combine", &ActionInitialization::CombineResponses,
+    "Predict the response of a bunch from the library, without simulation.\n"
+    "Usage: /B4/response/combine momentum(GeV) nPositrons nPions nProtons");
+  combineCmd.SetParameterName("parameters", false);
+  combineCmd.SetStates(G4State_PreInit, G4State_Idle);
+  combineCmd.SetToBeBroadcasted(false);
+
+  fScanMessenger = new G4GenericMessenger(
+    this, "/B4/scan/", "Scan of beam and ring configurations");
+
+  auto& scanCmd = fScanMessenger->DeclareMethod(
+    "run", &ActionInitialization::RunScan,
+    "Run N events for each configuration of a table, with one line per\n"
+    "configuration: name momentum(GeV) nPositrons nPions nProtons\n"
+    "radius(cm) [angles(deg) ...], the default angles if omitted. The\n"
+    "output files are named B4_name.\n"
+    "Usage: /B4/scan/run table N");
+  scanCmd.SetParameterName("parameters", false);
+  scanCmd.SetStates(G4State_Idle);
+  scanCmd.SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ActionInitialization::SetResponseFile(const G4String& fileName)
+{
+  ResponseLibrary::Instance()->SetFileName(fileName);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ActionInitialization::CombineResponses(const G4String& parameters)
+{
+  G4double momentum = 0.;
+  G4int nofPositrons = 0;
+  G4int nofPions = 0;
+  G4int nofProtons = 0;
+  std::istringstream is(parameters);
+  is >> momentum >> nofPositrons >> nofPions >> nofProtons;
+
+  if (is.fail() || momentum <= 0.) {
+    G4Exception("ActionInitialization::CombineResponses()", "MyCode0010",
+                JustWarning,
+                "Usage: /B4/response/combine momentum(GeV) nPositrons "
+                "nPions nProtons");
+    return;
+  }
+  ResponseLibrary::Instance()->Combine(momentum * GeV, nofPositrons,
+                                       nofPions, nofProtons);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ActionInitialization::RunScan(const G4String& parameters)
+{
+  G4String tableName;
+  G4int nofEvents = 0;
+  std::istringstream is(parameters);
+  is >> tableName >> nofEvents;
+
+  std::ifstream table(tableName);
+  if (is.fail() || nofEvents <= 0 || !table) {
+    G4ExceptionDescription msg;
+    msg << "Cannot read the scan table " << tableName
+        << "\nUsage: /B4/scan/run table N";
+    G4Exception("ActionInitialization::RunScan()", "MyCode0011", JustWarning,
+                msg);
+    return;
+  }
+
+  // the configurations are applied with the UI commands; the ring commands
+  // are issued only when the ring changes, so that the geometry is rebuilt
+  // only then, and the physics tables are kept
+  auto uiManager = G4UImanager::GetUIpointer();
+  auto detector = static_cast<const DetectorConstruction*>(
+    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  std::string line;
+  while (std::getline(table, line)) {
+    std::istringstream config(line);
+    G4String name;
+    G4double momentum = 0.;
+    G4int nofPositrons = 0;
+    G4int nofPions = 0;
+    G4int nofProtons = 0;
+    G4double radius = 0.;
+    if (!(config >> name) || name[0] == '#') continue;
+    config >> momentum >> nofPositrons >> nofPions >> nofProtons >> radius;
+    // the angles are optional: the stream is checked before reading them,
+    // as the reading fails at the end of a line without them
+    auto isValid = !config.fail();
+    std::string angles;
+    std::getline(config >> std::ws, angles);
+
+    // without angles, the ring of the configuration is the default one
+    std::vector<G4double> ringAngles;
+    std::istringstream anglesStream(angles);
+    G4double angle = 0.;
+    while (anglesStream >> angle) ringAngles.push_back(angle * deg);
+    if (angles.empty()) {
+      ringAngles = DetectorConstruction::GetDefaultRingAngles();
+    }
+
+    std::vector<G4String> commands = {
+      "/B4/gun/momentum " + std::to_string(momentum) + " GeV",
+      "/B4/gun/positrons " + std::to_string(nofPositrons),
+      "/B4/gun/pions " + std::to_string(nofPions),
+      "/B4/gun/protons " + std::to_string(nofProtons)};
+    if (radius * cm != detector->GetRingRadius()) {
+      std::ostringstream command;
+      command.precision(std::numeric_limits<G4double>::max_digits10);
+      command << "/B4/ring/radius " << radius << " cm";
+      commands.push_back(command.str());
+    }
+    if (ringAngles != detector->GetRingAngles()) {
+      std::ostringstream command;
+      command.precision(std::numeric_limits<G4double>::max_digits10);
+      command << "/B4/ring/angles";
+      for (auto ringAngle : ringAngles) command << ' ' << ringAngle / deg;
+      commands.push_back(command.str());
+    }
+    commands.push_back("/analysis/setFileName B4_" + name + ".root");
+
+    for (const auto& command : commands) {
+      if (!isValid) break;
+      isValid = (uiManager->ApplyCommand(command) == 0);
+    }
+    if (!isValid) {
+      G4ExceptionDescription msg;
+      msg << "Invalid scan configuration, skipped: " << line;
+      G4Exception("ActionInitialization::RunScan()", "MyCode0011",
+                  JustWarning, msg);
+      continue;
+    }
+
+    G4cout << G4endl << " Scan configuration " << name << ": " << momentum
+           << " GeV/c, " << nofPositrons << " e+, " << nofPions << " pi+, "
+           << nofProtons << " protons, ring radius " << radius << " cm"
+           << G4endl;
+    uiManager->ApplyCommand("/run/beamOn " + std::to_string(nofEvents));
+  }
+  uiManager->ApplyCommand("/analysis/setFileName B4.root");
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,115 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/AdaptiveRunManager.cc
+/// \brief Implementation of the B4d::AdaptiveRunManager class
+
+#include "AdaptiveRunManager.hh"
+#include "WorkerTimeline.hh"
+
+#include "G4AutoLock.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int AdaptiveRunManager::SetUpNEvents(G4Event *event,
+                                       G4SeedsQueue *seedsQueue,
+                                       G4bool reseedRequired) {
+  if (SeedOncePerCommunication() > 0) {
+    return G4MTRunManager::SetUpNEvents(event, seedsQueue, reseedRequired);
+  }
+
+  // the chunk size is set and used under the same lock
+  G4AutoLock lock(&fMutex);
+  eventModulo = GetChunkSize();
+  auto nofEvents =
+      G4MTRunManager::SetUpNEvents(event, seedsQueue, reseedRequired);
+  if (nofEvents > 0) {
+    if (fNofChunks == 0 || nofEvents < fMinChunkSize) {
+      fMinChunkSize = nofEvents;
+    }
+    fMaxChunkSize = std::max(fMaxChunkSize, nofEvents);
+    ++fNofChunks;
+  }
+  return nofEvents;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int AdaptiveRunManager::GetChunkSize() const {
+  auto nofRemaining = numberOfEventToBeProcessed - numberOfEventProcessed;
+  if (nofRemaining <= 0) return 1;
+
+  // share of the calling worker, from the event rates of all the workers
+  auto meanTimes = WorkerTimeline::Instance()->GetMeanEventTimes();
+  auto thread = std::size_t(std::max(0, G4Threading::G4GetThreadId()));
+  G4double share = 1. / std::max(1, numberOfThreads);
+  G4double meanTime = 0.;
+  if (thread < meanTimes.size() && meanTimes[thread] > 0.) {
+    G4double totalRate = 0.;
+    G4int nofMeasured = 0;
+    for (auto time : meanTimes) {
+      if (time > 0.) {
+        totalRate += 1. / time;
+        ++nofMeasured;
+      }
+    }
+    // the workers not measured yet are assumed as fast as the average
+    totalRate *= G4double(std::max(numberOfThreads, nofMeasured)) /
+                 nofMeasured;
+    meanTime = meanTimes[thread];
+    share = 1. / meanTime / totalRate;
+  }
+
+  auto chunkSize = G4int(std::ceil(0.5 * share * nofRemaining));
+  if (meanTime > 0.) {
+    chunkSize = std::max(chunkSize, G4int(fMinChunkTime / meanTime));
+  }
+  return std::clamp(chunkSize, 1, nofRemaining);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AdaptiveRunManager::RunTermination() {
+  G4MTRunManager::RunTermination();
+
+  if (fNofChunks > 0) {
+    G4cout << " Adaptive event chunks: " << fNofChunks << " chunks of "
+           << fMinChunkSize << " to " << fMaxChunkSize << " events" << G4endl;
+  }
+  fNofChunks = 0;
+  fMinChunkSize = 0;
+  fMaxChunkSize = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
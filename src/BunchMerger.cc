@@ -0,0 +1,77 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/BunchMerger.cc
+/// \brief Implementation of the B4d::BunchMerger class
+
+#include "BunchMerger.hh"
+
+#include "G4AutoLock.hh"
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+BunchMerger *BunchMerger::Instance() {
+  static BunchMerger instance;
+  return &instance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BunchMerger::Clear() {
+  G4AutoLock lock(&fMutex);
+  fBunches.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool BunchMerger::AddChunk(G4int bunchID, G4int nofChunks,
+                             std::vector<G4double> &record) {
+  G4AutoLock lock(&fMutex);
+
+  auto &bunch = fBunches[bunchID];
+  if (bunch.record.size() < record.size()) bunch.record.resize(record.size());
+  for (std::size_t i = 0; i < record.size(); ++i) {
+    bunch.record[i] += record[i];
+  }
+  if (++bunch.nofChunks < nofChunks) return false;
+
+  record = bunch.record;
+  fBunches.erase(bunchID);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int BunchMerger::GetNofIncompleteBunches() const {
+  G4AutoLock lock(&fMutex);
+  return G4int(fBunches.size());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,158 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/ConvergenceMonitor.cc
+/// \brief Implementation of the B4d::ConvergenceMonitor class
+
+#include "ConvergenceMonitor.hh"
+#include "Run.hh"
+
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ConvergenceMonitor *ConvergenceMonitor::Instance() {
+  static ConvergenceMonitor instance;
+  return &instance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::Start(const ConvergenceParameters &parameters,
+                               const std::vector<G4String> &detectorNames) {
+  G4AutoLock lock(&fMutex);
+
+  fRelativeError = parameters.relativeError;
+  fTimeBudget = parameters.timeBudget;
+  fMinEvents = parameters.minEvents;
+  fDetectorNames = detectorNames;
+  fNofEvents = 0;
+  fSums.assign(detectorNames.size(), 0.);
+  fSums2.assign(detectorNames.size(), 0.);
+  fStopReason = "";
+  fStartTime = std::chrono::steady_clock::now();
+
+  // requested detectors
+  fIsRequested.assign(detectorNames.size(), parameters.detectors == "all");
+  if (parameters.detectors != "all") {
+    std::istringstream is(parameters.detectors);
+    G4String name;
+    while (is >> name) {
+      auto it = std::find(detectorNames.begin(), detectorNames.end(), name);
+      if (it == detectorNames.end()) {
+        G4ExceptionDescription msg;
+        msg << "Unknown detector " << name << ", ignored.";
+        G4Exception("ConvergenceMonitor::Start()", "MyCode0007", JustWarning,
+                    msg);
+        continue;
+      }
+      fIsRequested[it - detectorNames.begin()] = true;
+    }
+  }
+
+  fIsStopped = false;
+  fIsActive = (fRelativeError > 0. || fTimeBudget > 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ConvergenceMonitor::AddEvent(const std::vector<G4double> &values) {
+  if (fIsStopped) return true;
+
+  G4AutoLock lock(&fMutex);
+  auto n = std::min(values.size(), fSums.size());
+  for (std::size_t i = 0; i < n; ++i) {
+    fSums[i] += values[i];
+    fSums2[i] += values[i] * values[i];
+  }
+  ++fNofEvents;
+
+  if (fTimeBudget > 0. && GetElapsedTime() > fTimeBudget) {
+    fStopReason = "wall time budget exhausted";
+  } else if (fRelativeError > 0. && fNofEvents >= fMinEvents &&
+             IsConverged()) {
+    fStopReason = "target relative error reached";
+  }
+  if (!fStopReason.empty()) fIsStopped = true;
+
+  return fIsStopped;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ConvergenceMonitor::IsConverged() const {
+  for (std::size_t i = 0; i < fSums.size(); ++i) {
+    if (!fIsRequested[i]) continue;
+    // no count yet: the error is not known
+    if (fSums[i] <= 0.) return false;
+    if (Run::GetRelativeError(fSums[i], fSums2[i], fNofEvents) >
+        fRelativeError) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double ConvergenceMonitor::GetElapsedTime() const {
+  std::chrono::duration<G4double> elapsed =
+      std::chrono::steady_clock::now() - fStartTime;
+  return elapsed.count() * s;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::Print() const {
+  if (!fIsActive) return;
+
+  G4AutoLock lock(&fMutex);
+  G4cout << " Adaptive run length: " << fNofEvents << " events in "
+         << GetElapsedTime() / s << " s, ";
+  if (fStopReason.empty()) {
+    G4cout << "all the requested events processed" << G4endl;
+  } else {
+    G4cout << fStopReason << G4endl;
+  }
+  for (std::size_t i = 0; i < fSums.size(); ++i) {
+    if (!fIsRequested[i]) continue;
+    G4cout << "   " << std::setw(9) << fDetectorNames[i] << ": "
+           << std::setw(8)
+           << 100. * Run::GetRelativeError(fSums[i], fSums2[i], fNofEvents)
+           << " % (target " << 100. * fRelativeError << " %)" << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
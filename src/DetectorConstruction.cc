@@ -28,14 +28,26 @@
 /// \brief Implementation of the B4d::DetectorConstruction class
 
 #include "DetectorConstruction.hh"
+#include "RingSD.hh"
+#include "Run.hh"
+#include "ShellBenchmark.hh"
+#include "ShellCrossingFilter.hh"
+#include "SpectrumScorer.hh"
+#include "StartupProfiler.hh"
+
 #include "G4AutoDelete.hh"
 #include "G4Box.hh"
+#include "G4GenericMessenger.hh"
 #include "G4GlobalMagFieldMessenger.hh"
 #include "G4LogicalVolume.hh"
 #include "G4Material.hh"
 #include "G4NistManager.hh"
 #include "G4PVPlacement.hh"
 #include "G4PVReplica.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4RunManager.hh"
+#include "G4StateManager.hh"
 #include "G4SubtractionSolid.hh"
 #include "G4Tubs.hh"
 
@@ -43,7 +55,7 @@
 #include "G4MultiFunctionalDetector.hh"
 #include "G4PSEnergyDeposit.hh"
 #include "G4PSTrackLength.hh"
-#include "G4PsTrackCounter.hh"
+#include "G4PSTrackCounter.hh"
 #include "G4SDChargedFilter.hh"
 #include "G4SDManager.hh"
 #include "G4SDParticleFilter.hh"
@@ -53,15 +65,43 @@
 
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
+#include <cmath>
+#include <sstream>
 #include <vector>
 
+namespace {
+
+// suffix of the names of the legacy ring scorers, as in the original setup:
+// "", "2", "3", ...
+G4String GetLegacySuffix(G4int detector) {
+  return (detector == 0) ? G4String() : G4String(std::to_string(detector + 1));
+}
+
+} // namespace
+
 namespace B4d {
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+G4ThreadLocal TargetShowerModel *DetectorConstruction::fShowerModel = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DetectorConstruction::DetectorConstruction() { DefineCommands(); }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DetectorConstruction::~DetectorConstruction() {
+  delete fMessenger;
+  delete fRingMessenger;
+  delete fFastMessenger;
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4VPhysicalVolume *DetectorConstruction::Construct() {
+  fGeometryChanged = false;
+
   // Define materials
   DefineMaterials();
 
@@ -80,22 +120,22 @@ void DetectorConstruction::DefineMaterials() {
   G4double z; // z=mean number of protons;
   G4double density;
 
-  // Vacuum
-  new G4Material("Galactic", z = 1., a = 1.01 * g / mole,
-                 density = universe_mean_density, kStateGas, 2.73 * kelvin,
-                 3.e-18 * pascal);
+  // Vacuum (the geometry, and so this method, may be rebuilt)
+  if (!G4Material::GetMaterial("Galactic", false)) {
+    new G4Material("Galactic", z = 1., a = 1.01 * g / mole,
+                   density = universe_mean_density, kStateGas, 2.73 * kelvin,
+                   3.e-18 * pascal);
+  }
 
   // Print materials
-  G4cout << *(G4Material::GetMaterialTable()) << G4endl;
+  if (fPrintMaterials) {
+    G4cout << *(G4Material::GetMaterialTable()) << G4endl;
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4VPhysicalVolume *DetectorConstruction::DefineVolumes() {
-  // Geometry parameters
-  G4double detHeight = 21 * cm;
-  G4double detDiameter = 22.86 * cm;
-
   // Get materials
   G4Material *gapMaterial = G4Material::GetMaterial("Galactic");
   G4Material *targetMaterial = G4Material::GetMaterial("G4_Pb");
@@ -118,37 +158,9 @@ G4VPhysicalVolume *DetectorConstruction::DefineVolumes() {
                                    0,               // copy number
                                    fCheckOverlaps); // checking overlaps
 
-  // Define dimensions for the outer box
-  G4double outerBoxXHalfLength = 2.0 * m;
-  G4double outerBoxYHalfLength = 2.0 * m;
-  G4double outerBoxZHalfLength = 2.0 * m;
+  // NDet shell; the Target and the detector ring are placed in its cavity
+  auto cavityLV = DefineShell(worldLV, gapMaterial);
 
-  // Define dimensions for the inner box (cavity)
-  G4double innerBoxXHalfLength = 1.8 * m;
-  G4double innerBoxYHalfLength = 1.8 * m;
-  G4double innerBoxZHalfLength = 1.8 * m;
-
-  // Create the outer box solid
-  G4Box *outerBoxSolid = new G4Box("OuterBox", outerBoxXHalfLength,
-                                   outerBoxYHalfLength, outerBoxZHalfLength);
-
-  // Create the inner box solid
-  G4Box *innerBoxSolid = new G4Box("InnerBox", innerBoxXHalfLength,
-                                   innerBoxYHalfLength, innerBoxZHalfLength);
-  G4SubtractionSolid *hollowBoxSolid =
-      new G4SubtractionSolid("HollowBox", outerBoxSolid, innerBoxSolid);
-
-  G4LogicalVolume *NDetLV =
-      new G4LogicalVolume(hollowBoxSolid, gapMaterial, "NDetLV");
-
-  new G4PVPlacement(nullptr,                            // no rotation
-                    G4ThreeVector(0 * m, 0 * m, 0 * m), // at (0,0,0)
-                    NDetLV,                             // its logical volume
-                    "NDet",                             // its name
-                    worldLV,                            // its mother  volume
-                    false,                              // no boolean operation
-                    0,                                  // copy number
-                    fCheckOverlaps);
   // Target
   // // auto TargetS = new G4Sphere("Target", 0., 5 * cm, 0., twopi, 0., pi);
   auto TargetS = new G4Box("Target",                   // its name
@@ -164,27 +176,43 @@ G4VPhysicalVolume *DetectorConstruction::DefineVolumes() {
                                       targetMaterial, // its material
                                       "Target");      // its name
 
-  auto TargetPV = new G4PVPlacement(Rotation,        // no rotation
-                                    G4ThreeVector(), // at (0,0,0)
-                                    TargetLV,        // its logical volume
-                                    "Target",        // its name
-                                    worldLV,         // its mother  volume
-                                    false,           // no boolean operation
-                                    0,               // copy number
-                                    fCheckOverlaps); // checking overlaps
-
-  auto TargetDetLV = new G4LogicalVolume(TargetS,     // its solid
-                                         gapMaterial, // its material
-                                         "TargetDetLV");
-
-  new G4PVPlacement(Rotation,        // no rotation
-                    G4ThreeVector(), //  its position
-                    TargetDetLV,     // its logical volume
-                    "TargetDet",     // its name
-                    worldLV,         // its mother  volume
-                    false,           // no boolean operation
-                    0,               // copy number
-                    fCheckOverlaps); // checking overlaps
+  // region of the fast shower model; the region is kept when the geometry
+  // is rebuilt, and the deleted logical volumes are removed from it
+  G4RegionStore::GetInstance()
+      ->FindOrCreateRegion("TargetRegion")
+      ->AddRootLogicalVolume(TargetLV);
+
+  // the target can be left out in the stage 2 of the two-stage simulation,
+  // where the primary neutrons are read from a phase space file
+  if (fPlaceTarget) {
+    auto TargetPV = new G4PVPlacement(Rotation,        // no rotation
+                                      G4ThreeVector(), // at (0,0,0)
+                                      TargetLV,        // its logical volume
+                                      "Target",        // its name
+                                      cavityLV,        // its mother  volume
+                                      false,           // no boolean operation
+                                      0,               // copy number
+                                      fCheckOverlaps); // checking overlaps
+  }
+
+  // the target scoring volume is placed in the TargetParallelWorld, or here
+  // in the legacy overlap mode, overlapping the Target
+  if (fTargetScoring == "overlap") {
+    auto TargetDetLV = new G4LogicalVolume(TargetS,     // its solid
+                                           gapMaterial, // its material
+                                           "TargetDetLV");
+
+    if (fPlaceTarget) {
+      new G4PVPlacement(Rotation,        // no rotation
+                        G4ThreeVector(), //  its position
+                        TargetDetLV,     // its logical volume
+                        "TargetDet",     // its name
+                        cavityLV,        // its mother  volume
+                        false,           // no boolean operation
+                        0,               // copy number
+                        fCheckOverlaps); // checking overlaps
+    }
+  }
 
   // auto TargetPV = new G4PVPlacement(nullptr,         // no rotation
   //                                   G4ThreeVector(), // at (0,0,0)
@@ -196,199 +224,45 @@ G4VPhysicalVolume *DetectorConstruction::DefineVolumes() {
   //                                   fCheckOverlaps); // checking overlaps
 
   //
-  // Gap
+  // Gap: ring of detectors sharing one solid and one logical volume
   //
 
-  auto gapS = new G4Tubs("Gap", 0., detDiameter / 2, detHeight / 2, 0., twopi);
+  auto gapS = new G4Tubs("Gap", 0., fDetectorDiameter / 2,
+                         fDetectorHeight / 2, 0., twopi);
 
   auto gapLV = new G4LogicalVolume(gapS,        // its solid
                                    gapMaterial, // its material
                                    "gapLV");    // its name
-
-  new G4PVPlacement(Rotation,                               // no rotation
-                    G4ThreeVector(0. * cm, 0., -80.5 * cm), //  its position
-                    gapLV,           // its logical volume
-                    "Gap",           // its name
-                    worldLV,         // its mother  volume
-                    false,           // no boolean operation
-                    0,               // copy number
-                    fCheckOverlaps); // checking overlaps
-  // --------------- det2
-  auto gapS2 =
-      new G4Tubs("Gap2", 0., detDiameter / 2, detHeight / 2, 0., twopi);
-
-  // auto gapS = new G4Box("Gap", // its name
-  //              15 * cm, 15 * cm, 20 * cm); // its
-  //              size
-
-  auto gapLV2 = new G4LogicalVolume(gapS2,       // its solid
-                                    gapMaterial, // its material
-                                    "gapLV2");   // its name
-
-  new G4PVPlacement(Rotation,                                  // no rotation
-                    G4ThreeVector(40.25 * cm, 0, -69.72 * cm), //  its position
-                    gapLV2,          // its logical volume
-                    "Gap2",          // its name
-                    worldLV,         // its mother  volume
-                    false,           // no boolean operation
-                    0,               // copy number
-                    fCheckOverlaps); // checking overlaps
-
-  // -----------------
-  // // --------------- det3
-  auto gapS3 =
-      new G4Tubs("Gap3", 0., detDiameter / 2, detHeight / 2, 0., twopi);
-
-  // auto gapS = new G4Box("Gap", // its name
-  //              15 * cm, 15 * cm, 20 * cm); // its
-  //              size
-
-  auto gapLV3 = new G4LogicalVolume(gapS3,       // its solid
-                                    gapMaterial, // its material
-                                    "gapLV3");   // its name
-
-  new G4PVPlacement(Rotation,                                  // no rotation
-                    G4ThreeVector(69.72 * cm, 0, -40.25 * cm), //  its position
-                    gapLV3,          // its logical volume
-                    "Gap3",          // its name
-                    worldLV,         // its mother  volume
-                    false,           // no boolean operation
-                    0,               // copy number
-                    fCheckOverlaps); // checking overlaps
-
-  // -----------------
-  // // --------------- det4
-  auto gapS4 =
-      new G4Tubs("Gap4", 0., detDiameter / 2, detHeight / 2, 0., twopi);
-
-  // auto gapS = new G4Box("Gap", // its name
-  //              15 * cm, 15 * cm, 20 * cm); // its
-  //              size
-
-  auto gapLV4 = new G4LogicalVolume(gapS4,       // its solid
-                                    gapMaterial, // its material
-                                    "gapLV4");   // its name
-
-  new G4PVPlacement(Rotation,                           // no rotation
-                    G4ThreeVector(80.5 * cm, 0, 0 * m), //  its position
-                    gapLV4,                             // its logical volume
-                    "Gap4",                             // its name
-                    worldLV,                            // its mother  volume
-                    false,                              // no boolean operation
-                    0,                                  // copy number
-                    fCheckOverlaps);                    // checking overlaps
-
-  // -----------------
-  // // --------------- det5
-  auto gapS5 =
-      new G4Tubs("Gap5", 0., detDiameter / 2, detHeight / 2, 0., twopi);
-
-  // auto gapS = new G4Box("Gap", // its name
-  //              15 * cm, 15 * cm, 20 * cm); // its
-  //              size
-
-  auto gapLV5 = new G4LogicalVolume(gapS5,       // its solid
-                                    gapMaterial, // its material
-                                    "gapLV5");   // its name
-
-  new G4PVPlacement(Rotation,                                 // no rotation
-                    G4ThreeVector(69.72 * cm, 0, 40.25 * cm), //  its position
-                    gapLV5,          // its logical volume
-                    "Gap5",          // its name
-                    worldLV,         // its mother  volume
-                    false,           // no boolean operation
-                    0,               // copy number
-                    fCheckOverlaps); // checking overlaps
-
-  // -----------------
-  // // --------------- det6
-  auto gapS6 =
-      new G4Tubs("Gap6", 0., detDiameter / 2, detHeight / 2, 0., twopi);
-
-  // auto gapS = new G4Box("Gap", // its name
-  //              15 * cm, 15 * cm, 20 * cm); // its
-  //              size
-
-  auto gapLV6 = new G4LogicalVolume(gapS6,       // its solid
-                                    gapMaterial, // its material
-                                    "gapLV6");   // its name
-
-  new G4PVPlacement(Rotation,                                 // no rotation
-                    G4ThreeVector(40.25 * cm, 0, 69.72 * cm), //  its position
-                    gapLV6,          // its logical volume
-                    "Gap6",          // its name
-                    worldLV,         // its mother  volume
-                    false,           // no boolean operation
-                    0,               // copy number
-                    fCheckOverlaps); // checking overlaps
-
-  // -----------------
-  // // --------------- det7
-  auto gapS7 =
-      new G4Tubs("Gap7", 0., detDiameter / 2, detHeight / 2, 0., twopi);
-
-  // auto gapS = new G4Box("Gap", // its name
-  //              15 * cm, 15 * cm, 20 * cm); // its
-  //              size
-
-  auto gapLV7 = new G4LogicalVolume(gapS7,       // its solid
-                                    gapMaterial, // its material
-                                    "gapLV7");   // its name
-
-  new G4PVPlacement(Rotation,                           // no rotation
-                    G4ThreeVector(0 * m, 0, 80.5 * cm), //  its position
-                    gapLV7,                             // its logical volume
-                    "Gap7",                             // its name
-                    worldLV,                            // its mother  volume
-                    false,                              // no boolean operation
-                    0,                                  // copy number
-                    fCheckOverlaps);                    // checking overlaps
-
-  // -----------------
-  // // --------------- det8
-  auto gapS8 =
-      new G4Tubs("Gap8", 0., detDiameter / 2, detHeight / 2, 0., twopi);
-
-  // auto gapS = new G4Box("Gap", // its name
-  //              15 * cm, 15 * cm, 20 * cm); // its
-  //              size
-
-  auto gapLV8 = new G4LogicalVolume(gapS8,       // its solid
-                                    gapMaterial, // its material
-                                    "gapLV8");   // its name
-
-  new G4PVPlacement(Rotation,                                  // no rotation
-                    G4ThreeVector(-40.25 * cm, 0, 69.72 * cm), //  its position
-                    gapLV8,          // its logical volume
-                    "Gap8",          // its name
-                    worldLV,         // its mother  volume
-                    false,           // no boolean operation
-                    0,               // copy number
-                    fCheckOverlaps); // checking overlaps
-
-  // -----------------
-  // // --------------- det9
-  auto gapS9 =
-      new G4Tubs("Gap9", 0., detDiameter / 2, detHeight / 2, 0., twopi);
-
-  // auto gapS = new G4Box("Gap", // its name
-  //              15 * cm, 15 * cm, 20 * cm); // its
-  //              size
-
-  auto gapLV9 = new G4LogicalVolume(gapS9,       // its solid
-                                    gapMaterial, // its material
-                                    "gapLV9");   // its name
-
-  new G4PVPlacement(Rotation,                                   // no rotation
-                    G4ThreeVector(-40.25 * cm, 0, -69.72 * cm), //  its position
-                    gapLV9,          // its logical volume
-                    "Gap9",          // its name
-                    worldLV,         // its mother  volume
-                    false,           // no boolean operation
-                    0,               // copy number
-                    fCheckOverlaps); // checking overlaps
-
-  // -----------------
+  std::vector<G4LogicalVolume *> ringLVs = {gapLV};
+
+  // the angle is measured from the z axis towards the x axis,
+  // the copy number is the index in the angle list; the legacy scorers
+  // need one logical volume per detector, placed with the copy number 0
+  auto isLegacy = (fRingScorer == "legacy");
+  for (std::size_t i = 0; i < fRingAngles.size(); ++i) {
+    G4ThreeVector position(fRingRadius * std::sin(fRingAngles[i]), 0.,
+                           fRingRadius * std::cos(fRingAngles[i]));
+    auto detectorLV = gapLV;
+    G4String name = "Gap";
+    auto copyNo = G4int(i);
+    if (isLegacy) {
+      if (i > 0) {
+        detectorLV = new G4LogicalVolume(
+            gapS, gapMaterial, "gapLV" + GetLegacySuffix(G4int(i)));
+        ringLVs.push_back(detectorLV);
+      }
+      name = RingSD::GetDetectorName(G4int(i));
+      copyNo = 0;
+    }
+    new G4PVPlacement(Rotation,        // rotation
+                      position,        // its position
+                      detectorLV,      // its logical volume
+                      name,            // its name
+                      cavityLV,        // its mother  volume
+                      false,           // no boolean operation
+                      copyNo,          // copy number
+                      fCheckOverlaps); // checking overlaps
+  }
 
   // Visualization attributes
   //
@@ -397,19 +271,8 @@ G4VPhysicalVolume *DetectorConstruction::DefineVolumes() {
   G4VisAttributes visAttributes;
   visAttributes.SetForceSolid(true);
   visAttributes.SetColor(G4Color::White());
-  G4VisAttributes visAttributesS;
-  visAttributesS.SetForceSolid(true);
-  visAttributesS.SetColor(G4Color::Red());
-
-  gapLV->SetVisAttributes(visAttributes);   // 180 degrees 2321
-  gapLV2->SetVisAttributes(visAttributesS); // 150 2313
-  gapLV3->SetVisAttributes(visAttributes);  // 120 2354
-  gapLV4->SetVisAttributes(visAttributes);  // 90 2557
-  gapLV5->SetVisAttributes(visAttributes);  // 60 2311
-  gapLV6->SetVisAttributes(visAttributes);  // 30 2231
-  gapLV7->SetVisAttributes(visAttributes);  // 0 degrees 2186
-  gapLV8->SetVisAttributes(visAttributesS); // 330 2150
-  gapLV9->SetVisAttributes(visAttributes);  // 210 Degrees 2178
+
+  for (auto ringLV : ringLVs) ringLV->SetVisAttributes(visAttributes);
   TargetLV->SetVisAttributes(visAttributes);
 
   //
@@ -420,8 +283,143 @@ G4VPhysicalVolume *DetectorConstruction::DefineVolumes() {
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+G4LogicalVolume *DetectorConstruction::DefineShell(G4LogicalVolume *worldLV,
+                                                   G4Material *material) {
+  // all the NDet volumes have the copy number 0, which indexes the NDet
+  // hits map
+  if (fShell == "slabs") {
+    auto slabs = GetShellSlabs(fShellHalfLength, fShellInnerHalfLength);
+    for (std::size_t i = 0; i < slabs.size(); ++i) {
+      const auto &halfLengths = slabs[i].halfLengths;
+      auto slabS = new G4Box("NDetSlab", halfLengths.x(), halfLengths.y(),
+                             halfLengths.z());
+      // the slabs share the logical volume name, see ConstructSDandField()
+      auto slabLV = new G4LogicalVolume(slabS, material, "NDetLV");
+      new G4PVPlacement(nullptr, slabs[i].position, slabLV, "NDet", worldLV,
+                        false, 0, fCheckOverlaps);
+    }
+    return worldLV;
+  }
+
+  // Create the outer box solid
+  auto outerBoxSolid = new G4Box("OuterBox", fShellHalfLength,
+                                 fShellHalfLength, fShellHalfLength);
+
+  // Create the inner box solid
+  auto innerBoxSolid =
+      new G4Box("InnerBox", fShellInnerHalfLength, fShellInnerHalfLength,
+                fShellInnerHalfLength);
+
+  if (fShell == "nested") {
+    auto NDetLV = new G4LogicalVolume(outerBoxSolid, material, "NDetLV");
+    new G4PVPlacement(nullptr, G4ThreeVector(), NDetLV, "NDet", worldLV,
+                      false, 0, fCheckOverlaps);
+
+    auto cavityLV = new G4LogicalVolume(innerBoxSolid, material, "CavityLV");
+    new G4PVPlacement(nullptr, G4ThreeVector(), cavityLV, "Cavity", NDetLV,
+                      false, 0, fCheckOverlaps);
+    cavityLV->SetVisAttributes(G4VisAttributes::GetInvisible());
+    return cavityLV;
+  }
+
+  G4SubtractionSolid *hollowBoxSolid =
+      new G4SubtractionSolid("HollowBox", outerBoxSolid, innerBoxSolid);
+
+  G4LogicalVolume *NDetLV =
+      new G4LogicalVolume(hollowBoxSolid, material, "NDetLV");
+
+  new G4PVPlacement(nullptr,                            // no rotation
+                    G4ThreeVector(0 * m, 0 * m, 0 * m), // at (0,0,0)
+                    NDetLV,                             // its logical volume
+                    "NDet",                             // its name
+                    worldLV,                            // its mother  volume
+                    false,                              // no boolean operation
+                    0,                                  // copy number
+                    fCheckOverlaps);
+  return worldLV;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::array<DetectorConstruction::ShellSlab, 6>
+DetectorConstruction::GetShellSlabs(G4double outerHalfLength,
+                                    G4double innerHalfLength) {
+  auto h = outerHalfLength;
+  auto i = innerHalfLength;
+  auto t = 0.5 * (h - i); // half thickness
+  auto c = 0.5 * (h + i); // distance of the slab centres
+  return {{{{t, h, h}, {-c, 0., 0.}},
+           {{t, h, h}, {c, 0., 0.}},
+           {{i, t, h}, {0., -c, 0.}},
+           {{i, t, h}, {0., c, 0.}},
+           {{i, i, t}, {0., 0., -c}},
+           {{i, i, t}, {0., 0., c}}}};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void DetectorConstruction::ConstructSDandField() {
-  G4SDManager::GetSDMpointer()->SetVerboseLevel(1);
+  auto profiler = StartupProfiler::Instance();
+  if (profiler) profiler->Mark("geometry");
+
+  auto sdManager = G4SDManager::GetSDMpointer();
+  sdManager->SetVerboseLevel(1);
+
+  // The sensitive detectors are created at the first call; when the geometry
+  // is rebuilt they are only attached to the new logical volumes
+  if (!sdManager->FindSensitiveDetector("NDet", false)) {
+    ConstructScorers();
+  }
+
+  if (fTargetScoring == "overlap") {
+    SetSensitiveDetector("TargetDetLV",
+                         sdManager->FindSensitiveDetector("TargetDet"));
+  }
+  SetSensitiveDetector("NDetLV", sdManager->FindSensitiveDetector("NDet"),
+                       fShell == "slabs");
+
+  //
+  // Detector ring
+  //
+  if (fRingScorer == "legacy") {
+    // the scorers of the detectors added by a ring command are created
+    // when the geometry is rebuilt
+    for (G4int i = 0; i < GetNofRingDetectors(); ++i) {
+      auto gapDetector = sdManager->FindSensitiveDetector(
+          RingSD::GetDetectorName(i), false);
+      if (!gapDetector) gapDetector = ConstructLegacyRingScorer(i);
+      SetSensitiveDetector("gapLV" + GetLegacySuffix(i), gapDetector);
+    }
+  } else {
+    auto ringSD =
+        static_cast<RingSD *>(sdManager->FindSensitiveDetector("Ring"));
+    ringSD->SetNofDetectors(GetNofRingDetectors());
+    SetSensitiveDetector("gapLV", ringSD);
+  }
+
+  //
+  // Fast shower model, attached to the TargetRegion which is kept when the
+  // geometry is rebuilt; only with the fast simulation physics
+  //
+  if (fFastSimulation && !fShowerModel) {
+    fShowerModel = new TargetShowerModel(
+        "TargetShowerModel",
+        G4RegionStore::GetInstance()->FindOrCreateRegion("TargetRegion"),
+        &fFastShowerParameters);
+  }
+
+  //
+  // Magnetic field
+  //
+  // Create global magnetic field messenger.
+  // Uniform magnetic field is then created automatically if
+
+  if (profiler) profiler->Mark("sensitive detectors and fields");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::ConstructScorers() {
   //
   // Scorers
   //
@@ -429,50 +427,30 @@ void DetectorConstruction::ConstructSDandField() {
   // primitive ->SetFilter(charged);
   // absDetector->RegisterPrimitive(primitive);
 
-  // declare Gap as a MultiFunctionalDetector scorer
-
   G4MultiFunctionalDetector *TargetDet =
       new G4MultiFunctionalDetector("TargetDet");
   G4MultiFunctionalDetector *NDet = new G4MultiFunctionalDetector("NDet");
 
-  G4MultiFunctionalDetector *gapDetector = new G4MultiFunctionalDetector("Gap");
-  G4MultiFunctionalDetector *gapDetector2 =
-      new G4MultiFunctionalDetector("Gap2");
-  G4MultiFunctionalDetector *gapDetector3 =
-      new G4MultiFunctionalDetector("Gap3");
-  G4MultiFunctionalDetector *gapDetector4 =
-      new G4MultiFunctionalDetector("Gap4");
-  G4MultiFunctionalDetector *gapDetector5 =
-      new G4MultiFunctionalDetector("Gap5");
-  G4MultiFunctionalDetector *gapDetector6 =
-      new G4MultiFunctionalDetector("Gap6");
-  G4MultiFunctionalDetector *gapDetector7 =
-      new G4MultiFunctionalDetector("Gap7");
-  G4MultiFunctionalDetector *gapDetector8 =
-      new G4MultiFunctionalDetector("Gap8");
-  G4MultiFunctionalDetector *gapDetector9 =
-      new G4MultiFunctionalDetector("Gap9");
-
   G4SDManager::GetSDMpointer()->AddNewDetector(TargetDet);
   G4SDManager::GetSDMpointer()->AddNewDetector(NDet);
-  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector);
-  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector2);
-  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector3);
-  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector4);
-  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector5);
-  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector6);
-  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector7);
-  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector8);
-  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector9);
 
   G4VPrimitiveScorer *primitive;
+  // the track counters are weighted, for the neutron biasing
   G4PSTrackCounter *scorerN =
       new G4PSTrackCounter("TrackCounter", fCurrent_InOut);
+  scorerN->Weighted(true);
+  // the crossings between the slabs of the shell are not counted
+  scorerN->SetFilter(
+      new ShellCrossingFilter("NDetCrossing", ShellCrossingFilter::kCrossing));
   primitive = scorerN;
   G4SDParticleFilter *neutronFilter =
       new G4SDParticleFilter("neutronFilter", "neutron");
   NDet->SetFilter(neutronFilter);
   NDet->RegisterPrimitive(primitive);
+  auto spectrumScorer = new SpectrumScorer("Spectra", Run::kNDetSpectrum);
+  spectrumScorer->SetFilter(
+      new ShellCrossingFilter("NDetEntry", ShellCrossingFilter::kEntry));
+  NDet->RegisterPrimitive(spectrumScorer);
 
   G4PSTrackLength *scorerT = new G4PSTrackLength("TrackLength");
   primitive = scorerT;
@@ -481,109 +459,293 @@ void DetectorConstruction::ConstructSDandField() {
   auto charged = new G4SDChargedFilter("chargedFilter");
   primitive->SetFilter(charged);
   TargetDet->RegisterPrimitive(primitive);
-  // ------------------------ 1
-  G4PSTrackCounter *scorer = new G4PSTrackCounter("TrackCounter", fCurrent_In);
-  primitive = scorer;
 
-  gapDetector->SetFilter(neutronFilter);
-  gapDetector->RegisterPrimitive(primitive);
+  // the legacy ring scorers are created in ConstructSDandField()
+  if (fRingScorer != "legacy") {
+    auto ringSD = new RingSD("Ring", GetNofRingDetectors());
+    G4SDManager::GetSDMpointer()->AddNewDetector(ringSD);
+  }
+}
 
-  // ------------------------
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-  // ------------------------ 2
-  G4PSTrackCounter *scorer2 =
-      new G4PSTrackCounter("TrackCounter2", fCurrent_In);
-  primitive = scorer2;
+G4VSensitiveDetector *
+DetectorConstruction::ConstructLegacyRingScorer(G4int detector) const {
+  // declare Gap, Gap2, ... as MultiFunctionalDetector scorers, with the
+  // TrackCounter, TrackCounter2, ... primitives of the original setup;
+  // the track counters are weighted, for the neutron biasing
+  auto suffix = GetLegacySuffix(detector);
+  G4MultiFunctionalDetector *gapDetector =
+      new G4MultiFunctionalDetector("Gap" + suffix);
+  G4SDManager::GetSDMpointer()->AddNewDetector(gapDetector);
 
-  gapDetector2->SetFilter(neutronFilter);
-  gapDetector2->RegisterPrimitive(primitive);
+  G4PSTrackCounter *scorer =
+      new G4PSTrackCounter("TrackCounter" + suffix, fCurrent_In);
+  scorer->Weighted(true);
 
-  // ------------------------
-  //
-  // ------------------------ 3
-  G4PSTrackCounter *scorer3 =
-      new G4PSTrackCounter("TrackCounter3", fCurrent_In);
-  primitive = scorer3;
+  gapDetector->SetFilter(new G4SDParticleFilter("neutronFilter", "neutron"));
+  gapDetector->RegisterPrimitive(scorer);
+  gapDetector->RegisterPrimitive(new SpectrumScorer("Spectra", detector));
+  return gapDetector;
+}
 
-  gapDetector3->SetFilter(neutronFilter);
-  gapDetector3->RegisterPrimitive(primitive);
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-  // ------------------------
-  //
-  // ------------------------ 4
-  G4PSTrackCounter *scorer4 =
-      new G4PSTrackCounter("TrackCounter4", fCurrent_In);
-  primitive = scorer4;
+G4String DetectorConstruction::GetLegacyCollectionName(G4int detector) {
+  auto suffix = GetLegacySuffix(detector);
+  return "Gap" + suffix + "/TrackCounter" + suffix;
+}
 
-  gapDetector4->SetFilter(neutronFilter);
-  gapDetector4->RegisterPrimitive(primitive);
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-  // ------------------------
-  //
-  // ------------------------ 5
-  G4PSTrackCounter *scorer5 =
-      new G4PSTrackCounter("TrackCounter5", fCurrent_In);
-  primitive = scorer5;
-  gapDetector5->SetFilter(neutronFilter);
-  gapDetector5->RegisterPrimitive(primitive);
-
-  // ------------------------
-  //
-  // ------------------------ 6
-  G4PSTrackCounter *scorer6 =
-      new G4PSTrackCounter("TrackCounter6", fCurrent_In);
-  primitive = scorer6;
+std::vector<G4double> DetectorConstruction::GetDefaultRingAngles() {
+  return {180. * deg, 150. * deg, 120. * deg, 90. * deg, 60. * deg,
+          30. * deg,  0. * deg,   330. * deg, 210. * deg};
+}
 
-  gapDetector6->SetFilter(neutronFilter);
-  gapDetector6->RegisterPrimitive(primitive);
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-  // ------------------------
-  //
-  // ------------------------ 7
-  G4PSTrackCounter *scorer7 =
-      new G4PSTrackCounter("TrackCounter7", fCurrent_In);
-  primitive = scorer7;
-  gapDetector7->SetFilter(neutronFilter);
-  gapDetector7->RegisterPrimitive(primitive);
-
-  // ------------------------
-  //
-  // ------------------------ 8
-  G4PSTrackCounter *scorer8 =
-      new G4PSTrackCounter("TrackCounter8", fCurrent_In);
-  primitive = scorer8;
-  gapDetector8->SetFilter(neutronFilter);
-  gapDetector8->RegisterPrimitive(primitive);
-
-  // ------------------------
-  //
-  // ------------------------ 9
-  G4PSTrackCounter *scorer9 =
-      new G4PSTrackCounter("TrackCounter9", fCurrent_In);
-  primitive = scorer9;
-
-  gapDetector9->SetFilter(neutronFilter);
-  gapDetector9->RegisterPrimitive(primitive);
-
-  // ------------------------
-
-  SetSensitiveDetector("TargetDetLV", TargetDet);
-  SetSensitiveDetector("NDetLV", NDet);
-  SetSensitiveDetector("gapLV", gapDetector);
-  SetSensitiveDetector("gapLV2", gapDetector2);
-  SetSensitiveDetector("gapLV3", gapDetector3);
-  SetSensitiveDetector("gapLV4", gapDetector4);
-  SetSensitiveDetector("gapLV5", gapDetector5);
-  SetSensitiveDetector("gapLV6", gapDetector6);
-  SetSensitiveDetector("gapLV7", gapDetector7);
-  SetSensitiveDetector("gapLV8", gapDetector8);
-  SetSensitiveDetector("gapLV9", gapDetector9);
+void DetectorConstruction::DefineCommands() {
+  fMessenger = new G4GenericMessenger(this, "/B4/det/", "Detector control");
+
+  auto &ringScorerCmd = fMessenger->DeclareProperty(
+      "ringScorer", fRingScorer,
+      "Select the detector ring scorer: ring (single indexed sensitive\n"
+      "detector) or legacy (one G4MultiFunctionalDetector per detector).");
+  ringScorerCmd.SetParameterName("scorer", false);
+  ringScorerCmd.SetCandidates("ring legacy");
+  ringScorerCmd.SetStates(G4State_PreInit);
+
+  auto &checkOverlapsCmd = fMessenger->DeclareProperty(
+      "checkOverlaps", fCheckOverlaps,
+      "Check the overlaps of the volumes when they are placed.");
+  checkOverlapsCmd.SetParameterName("flag", false);
+  checkOverlapsCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto &printMaterialsCmd = fMessenger->DeclareProperty(
+      "printMaterials", fPrintMaterials,
+      "Print the material table when the geometry is built.");
+  printMaterialsCmd.SetParameterName("flag", false);
+  printMaterialsCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto &shellCmd = fMessenger->DeclareMethod(
+      "shell", &DetectorConstruction::SetShell,
+      "Select the NDet shell construction: subtraction (boolean solid),\n"
+      "nested (box with a cavity daughter) or slabs (six boxes).");
+  shellCmd.SetParameterName("shell", false);
+  shellCmd.SetCandidates("subtraction nested slabs");
+  shellCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto &benchmarkCmd = fMessenger->DeclareMethod(
+      "benchmarkShell", &DetectorConstruction::BenchmarkShell,
+      "Time the navigation on the NDet shell constructions with N random\n"
+      "points, and in the current geometry.");
+  benchmarkCmd.SetParameterName("N", false);
+  benchmarkCmd.SetRange("N>0");
+  benchmarkCmd.SetStates(G4State_Idle);
+  benchmarkCmd.SetToBeBroadcasted(false);
+
+  auto &placeTargetCmd = fMessenger->DeclareProperty(
+      "placeTarget", fPlaceTarget,
+      "Place the Target (default). Set it false to simulate the detectors\n"
+      "only, eg. with primaries read from a phase space file.");
+  placeTargetCmd.SetParameterName("flag", false);
+  placeTargetCmd.SetStates(G4State_PreInit);
+
+  // The fast shower parameters are read directly by the models of all
+  // threads, so the commands are executed on the master only
+  fFastMessenger = new G4GenericMessenger(
+      this, "/B4/fast/", "Fast simulation of the EM showers in the Target");
+
+  auto &enableCmd = fFastMessenger->DeclareMethod(
+      "enable", &DetectorConstruction::SetFastShowers,
+      "Parameterize the e+, e- and gamma showers in the Target; it needs\n"
+      "the fast simulation physics, registered with the -f option.");
+  enableCmd.SetParameterName("flag", false);
+  enableCmd.SetStates(G4State_PreInit, G4State_Idle);
+  enableCmd.SetToBeBroadcasted(false);
+
+  auto &thresholdCmd = fFastMessenger->DeclarePropertyWithUnit(
+      "threshold", "MeV", fFastShowerParameters.energyThreshold,
+      "Parameterize the showers above this kinetic energy.");
+  thresholdCmd.SetParameterName("energy", false);
+  thresholdCmd.SetRange("energy>0.");
+  thresholdCmd.SetStates(G4State_PreInit, G4State_Idle);
+  thresholdCmd.SetToBeBroadcasted(false);
+
+  auto &yieldCmd = fFastMessenger->DeclareProperty(
+      "neutronYield", fFastShowerParameters.neutronYield,
+      "Mean number of photonuclear neutrons per GeV of shower energy.");
+  yieldCmd.SetParameterName("yield", false);
+  yieldCmd.SetRange("yield>=0.");
+  yieldCmd.SetStates(G4State_PreInit, G4State_Idle);
+  yieldCmd.SetToBeBroadcasted(false);
+
+  auto &temperatureCmd = fFastMessenger->DeclarePropertyWithUnit(
+      "temperature", "MeV", fFastShowerParameters.temperature,
+      "Temperature of the evaporation spectrum of the neutrons.");
+  temperatureCmd.SetParameterName("temperature", false);
+  temperatureCmd.SetRange("temperature>0.");
+  temperatureCmd.SetStates(G4State_PreInit, G4State_Idle);
+  temperatureCmd.SetToBeBroadcasted(false);
+
+  auto &validateCmd = fFastMessenger->DeclareProperty(
+      "validate", fFastShowerParameters.validate,
+      "At the end of a run with the fast simulation, compare the ring\n"
+      "counts with those of the last run with the full simulation.");
+  validateCmd.SetParameterName("flag", false);
+  validateCmd.SetStates(G4State_PreInit, G4State_Idle);
+  validateCmd.SetToBeBroadcasted(false);
+
+  fRingMessenger =
+      new G4GenericMessenger(this, "/B4/ring/", "Detector ring geometry");
+
+  auto &radiusCmd = fRingMessenger->DeclareMethodWithUnit(
+      "radius", "cm", &DetectorConstruction::SetRingRadius,
+      "Set the distance of the detectors from the target centre.");
+  radiusCmd.SetParameterName("radius", false);
+  radiusCmd.SetRange("radius>0.");
+  radiusCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto &anglesCmd = fRingMessenger->DeclareMethod(
+      "angles", &DetectorConstruction::SetRingAngles,
+      "Set the list of the detector angles (deg), measured from the z axis\n"
+      "towards the x axis. The copy number is the index in the list.");
+  anglesCmd.SetParameterName("angles", false);
+  anglesCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto &uniformCmd = fRingMessenger->DeclareMethod(
+      "uniform", &DetectorConstruction::SetUniformRing,
+      "Place N detectors starting at angle start (deg) with a step (deg).\n"
+      "Usage: /B4/ring/uniform N start step");
+  uniformCmd.SetParameterName("parameters", false);
+  uniformCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto &diameterCmd = fRingMessenger->DeclareMethodWithUnit(
+      "detectorDiameter", "cm", &DetectorConstruction::SetDetectorDiameter,
+      "Set the diameter of the detectors.");
+  diameterCmd.SetParameterName("diameter", false);
+  diameterCmd.SetRange("diameter>0.");
+  diameterCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+  auto &heightCmd = fRingMessenger->DeclareMethodWithUnit(
+      "detectorHeight", "cm", &DetectorConstruction::SetDetectorHeight,
+      "Set the height of the detectors.");
+  heightCmd.SetParameterName("height", false);
+  heightCmd.SetRange("height>0.");
+  heightCmd.SetStates(G4State_PreInit, G4State_Idle);
+}
 
-  //
-  // Magnetic field
-  //
-  // Create global magnetic field messenger.
-  // Uniform magnetic field is then created automatically if
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetRingRadius(G4double radius) {
+  // the geometry is rebuilt only on a change
+  if (radius == fRingRadius) return;
+  fRingRadius = radius;
+  GeometryHasChanged();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetRingAngles(const G4String &angles) {
+  std::vector<G4double> ringAngles;
+  std::istringstream is(angles);
+  G4double angle;
+  while (is >> angle) ringAngles.push_back(angle * deg);
+
+  if (ringAngles.empty()) {
+    G4Exception("DetectorConstruction::SetRingAngles()", "MyCode0004",
+                JustWarning, "Empty angle list, the ring is unchanged.");
+    return;
+  }
+  if (ringAngles == fRingAngles) return;
+  fRingAngles = ringAngles;
+  GeometryHasChanged();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetUniformRing(const G4String &parameters) {
+  G4int nofDetectors = 0;
+  G4double start = 0.;
+  G4double step = 0.;
+  std::istringstream is(parameters);
+  is >> nofDetectors >> start >> step;
+
+  if (is.fail() || nofDetectors <= 0) {
+    G4Exception("DetectorConstruction::SetUniformRing()", "MyCode0004",
+                JustWarning, "Usage: /B4/ring/uniform N start step");
+    return;
+  }
+  std::vector<G4double> ringAngles;
+  for (G4int i = 0; i < nofDetectors; ++i) {
+    ringAngles.push_back((start + i * step) * deg);
+  }
+  if (ringAngles == fRingAngles) return;
+  fRingAngles = ringAngles;
+  GeometryHasChanged();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetDetectorDiameter(G4double diameter) {
+  if (diameter == fDetectorDiameter) return;
+  fDetectorDiameter = diameter;
+  GeometryHasChanged();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetDetectorHeight(G4double height) {
+  if (height == fDetectorHeight) return;
+  fDetectorHeight = height;
+  GeometryHasChanged();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetShell(const G4String &shell) {
+  fShell = shell;
+  GeometryHasChanged();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetFastShowers(G4bool enable) {
+  if (enable && !fFastSimulation) {
+    G4Exception("DetectorConstruction::SetFastShowers()", "MyCode0014",
+                JustWarning,
+                "The fast simulation physics is not registered: run with\n"
+                "the -f option. The showers are not parameterized.");
+    return;
+  }
+  fFastShowerParameters.enabled = enable;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::BenchmarkShell(G4int nofPoints) {
+  // the navigation is timed in the current world, which is already deleted
+  // when a geometry command was issued since the last run
+  if (fGeometryChanged) {
+    G4Exception("DetectorConstruction::BenchmarkShell()", "MyCode0009",
+                JustWarning,
+                "The geometry was changed: run /run/beamOn 0 first.");
+    return;
+  }
+
+  ShellBenchmark benchmark(fShellHalfLength, fShellInnerHalfLength);
+  benchmark.Run(nofPoints);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::GeometryHasChanged() {
+  // rebuild the geometry at the next run if it was already constructed
+  if (G4StateManager::GetStateManager()->GetCurrentState() == G4State_Idle) {
+    G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+    fGeometryChanged = true;
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
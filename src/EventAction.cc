@@ -28,6 +28,13 @@
 /// \brief Implementation of the B4d::EventAction class
 
 #include "EventAction.hh"
+#include "BunchMerger.hh"
+#include "ConvergenceMonitor.hh"
+#include "DetectorConstruction.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "Run.hh"
+#include "StartupProfiler.hh"
+#include "WorkerTimeline.hh"
 
 #include "G4AnalysisManager.hh"
 #include "G4Event.hh"
@@ -42,6 +49,12 @@
 namespace B4d {
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventAction::EventAction(const B4::GunParameters *gunParameters)
+    : fGunParameters(gunParameters) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 G4THitsMap<G4double> *
 EventAction::GetHitsCollection(G4int hcID, const G4Event *event) const {
   auto hitsCollection = static_cast<G4THitsMap<G4double> *>(
@@ -59,35 +72,104 @@ EventAction::GetHitsCollection(G4int hcID, const G4Event *event) const {
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-G4double EventAction::GetSum(G4THitsMap<G4double> *hitsMap) const {
-  G4double sumValue = 0.;
-  for (auto it : *hitsMap->GetMap()) {
-    // hitsMap->GetMap() returns the map of std::map<G4int, G4double*>
-    sumValue += *(it.second);
+G4double EventAction::GetValue(G4int hcID, const G4Event *event) const {
+  // single volume detectors: the value is stored with the copy number 0
+  auto value = GetHitsCollection(hcID, event)->GetObject(0);
+  return value ? *value : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventAction::ReadRingCounts(const G4Event *event) {
+  auto sdManager = G4SDManager::GetSDMpointer();
+  if (!fRingSD && fGapTrackCounterHCIDs.empty()) {
+    fRingSD =
+        static_cast<RingSD *>(sdManager->FindSensitiveDetector("Ring", false));
+  }
+
+  if (fRingSD) {
+    fRingCounts = fRingSD->GetCounts();
+    return;
+  }
+
+  // legacy ring scorers: one hits collection per detector, the IDs of the
+  // detectors added by a ring command are looked up once
+  auto nofDetectors = static_cast<const DetectorConstruction *>(
+                          G4RunManager::GetRunManager()
+                              ->GetUserDetectorConstruction())
+                          ->GetNofRingDetectors();
+  for (auto i = G4int(fGapTrackCounterHCIDs.size()); i < nofDetectors; ++i) {
+    fGapTrackCounterHCIDs.push_back(sdManager->GetCollectionID(
+        DetectorConstruction::GetLegacyCollectionName(i)));
+  }
+  fRingCounts.resize(nofDetectors);
+  for (G4int i = 0; i < nofDetectors; ++i) {
+    fRingCounts[i] = GetValue(fGapTrackCounterHCIDs[i], event);
   }
-  return sumValue;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void EventAction::BeginOfEventAction(const G4Event * /*event*/) {}
+void EventAction::BeginOfEventAction(const G4Event * /*event*/) {
+  fEventStartTime = WorkerTimeline::Instance()->GetTime();
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void EventAction::EndOfEventAction(const G4Event *event) {
-  // Get hist collections IDs
-  fGapTrackCounterHCID =
-      G4SDManager::GetSDMpointer()->GetCollectionID("Gap/TrackCounter");
-  fTargetTrackLengthHCID =
-      G4SDManager::GetSDMpointer()->GetCollectionID("TargetDet/TrackLength");
-  fNTrackCounterHCID =
-      G4SDManager::GetSDMpointer()->GetCollectionID("NDet/TrackCounter");
-
-  // Get sum values from hits collections
-  auto gapTrackCounter = GetSum(GetHitsCollection(fGapTrackCounterHCID, event));
-  auto TargetTrackLength =
-      GetSum(GetHitsCollection(fTargetTrackLengthHCID, event));
-  auto NTrackCounter = GetSum(GetHitsCollection(fNTrackCounterHCID, event));
+  // End of the startup timing at the first event
+  auto profiler = StartupProfiler::Instance();
+  if (profiler) profiler->EndOfEvent();
+  WorkerTimeline::Instance()->AddEvent(fEventStartTime);
+
+  // Get hits collections IDs, only once: the sensitive detectors are kept
+  // when the geometry is rebuilt
+  if (fTargetTrackLengthHCID < 0) {
+    auto sdManager = G4SDManager::GetSDMpointer();
+    fTargetTrackLengthHCID =
+        sdManager->GetCollectionID("TargetDet/TrackLength");
+    fNTrackCounterHCID = sdManager->GetCollectionID("NDet/TrackCounter");
+  }
+
+  // Get neutron counts of the detector ring
+  ReadRingCounts(event);
+
+  auto run = static_cast<Run *>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  run->AddRingCounts(fRingCounts);
+
+  // Get values from hits collections
+  auto TargetTrackLength = GetValue(fTargetTrackLengthHCID, event);
+  auto NTrackCounter = GetValue(fNTrackCounterHCID, event);
+
+  // Event record: all the detectors, contiguous
+  auto nofRingDetectors = fRingCounts.size();
+  fRecord.assign(fRingCounts.begin(), fRingCounts.end());
+  fRecord.push_back(TargetTrackLength);
+  fRecord.push_back(NTrackCounter);
+
+  // Single species mode: response per primary
+  auto isBunch = (fGunParameters->species == "bunch");
+  if (!isBunch) run->AddResponse(fRecord);
+
+  // Sub-event mode: fill the output only with the complete bunch
+  auto nofChunks = isBunch ? fGunParameters->chunksPerBunch : 1;
+  if (nofChunks > 1) {
+    if (!BunchMerger::Instance()->AddChunk(event->GetEventID() / nofChunks,
+                                           nofChunks, fRecord)) {
+      return;
+    }
+    fRingCounts.assign(fRecord.begin(), fRecord.begin() + nofRingDetectors);
+    TargetTrackLength = fRecord[nofRingDetectors];
+    NTrackCounter = fRecord[nofRingDetectors + 1];
+  }
+  auto gapTrackCounter = fRingCounts[0];
+
+  // Adaptive run length: stop the run once converged
+  auto monitor = ConvergenceMonitor::Instance();
+  if (monitor->IsActive() && monitor->AddEvent(fRecord)) {
+    G4RunManager::GetRunManager()->AbortRun(true);
+  }
 
   // get analysis manager
   G4AnalysisManager *analysisManager = G4AnalysisManager::Instance();
@@ -96,11 +178,9 @@ void EventAction::EndOfEventAction(const G4Event *event) {
   //
   analysisManager->FillH1(0, gapTrackCounter);
 
-  // fill ntuple
+  // fill ntuple; the Detectors column is filled from the record directly
   //
   analysisManager->FillNtupleDColumn(0, gapTrackCounter);
-  analysisManager->FillNtupleDColumn(1, TargetTrackLength);
-  analysisManager->FillNtupleDColumn(2, NTrackCounter);
   analysisManager->AddNtupleRow();
 
   // print per event (modulo n)
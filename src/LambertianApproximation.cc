@@ -0,0 +1,97 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/LambertianApproximation.cc
+/// \brief Implementation of the B4d::LambertianApproximation class
+
+#include "LambertianApproximation.hh"
+
+#include "G4PhysicalConstants.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LambertianApproximation::SetRing(G4double radius,
+                                 const std::vector<G4double> &angles,
+                                 G4double diameter, G4double height) {
+  // same placement as in DetectorConstruction
+  fX.resize(angles.size());
+  fY.assign(angles.size(), 0.);
+  fZ.resize(angles.size());
+  for (std::size_t i = 0; i < angles.size(); ++i) {
+    fX[i] = radius * std::sin(angles[i]);
+    fZ[i] = radius * std::cos(angles[i]);
+  }
+  fSideArea = diameter * height;
+  fEndArea = pi * diameter * diameter / 4;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LambertianApproximation::Score(const G4ThreeVector &position,
+                               const G4ThreeVector &normal, G4double weight,
+                               G4double *scores) const {
+  const G4double px = position.x();
+  const G4double py = position.y();
+  const G4double pz = position.z();
+  const G4double nx = normal.x();
+  const G4double ny = normal.y();
+  const G4double nz = normal.z();
+  const G4double factor = weight / pi;
+
+  const auto n = fX.size();
+  const G4double *x = fX.data();
+  const G4double *y = fY.data();
+  const G4double *z = fZ.data();
+
+  for (std::size_t i = 0; i < n; ++i) {
+    const G4double dx = x[i] - px;
+    const G4double dy = y[i] - py;
+    const G4double dz = z[i] - pz;
+    const G4double distance2 = dx * dx + dy * dy + dz * dz;
+    const G4double invDistance = 1. / std::sqrt(distance2);
+
+    // angle to the detector axis (y) and projected area of the cylinder
+    const G4double cosAxis = std::abs(dy) * invDistance;
+    const G4double sinAxis = std::sqrt(std::max(0., 1. - cosAxis * cosAxis));
+    const G4double solidAngle =
+        (fSideArea * sinAxis + fEndArea * cosAxis) / distance2;
+
+    // cosine exit distribution, nothing goes back into the target
+    const G4double cosNormal =
+        std::max(0., (dx * nx + dy * ny + dz * nz) * invDistance);
+
+    scores[i] += factor * solidAngle * cosNormal;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
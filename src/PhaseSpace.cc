@@ -0,0 +1,174 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/PhaseSpace.cc
+/// \brief Implementation of the B4d phase space classes
+
+#include "PhaseSpace.hh"
+
+#include "G4AutoDelete.hh"
+#include "G4AutoLock.hh"
+
+#include <cstring>
+
+namespace {
+
+const char kMagic[4] = {'B', '4', 'P', 'S'};
+const std::size_t kBufferSize = 4096;
+
+G4ThreadLocal std::vector<B4d::PhaseSpaceRecord> *gBuffer = nullptr;
+
+} // namespace
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhaseSpaceWriter *PhaseSpaceWriter::Instance() {
+  static PhaseSpaceWriter instance;
+  return &instance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhaseSpaceWriter::Open(const G4String &fileName) {
+  G4AutoLock lock(&fMutex);
+  // the file of an earlier run of the job is continued
+  auto append = (fileName == fFileName);
+  fFile.open(fileName,
+             std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+  if (!fFile) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open phase space file " << fileName;
+    G4Exception("PhaseSpaceWriter::Open()", "MyCode0005", JustWarning, msg);
+    return;
+  }
+  if (!append) fFile.write(kMagic, sizeof(kMagic));
+  fFileName = fileName;
+  fNofRecords = 0;
+  fIsOpen = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhaseSpaceWriter::Fill(const PhaseSpaceRecord &record) {
+  if (!gBuffer) {
+    gBuffer = new std::vector<PhaseSpaceRecord>;
+    gBuffer->reserve(kBufferSize);
+    G4AutoDelete::Register(gBuffer);
+  }
+  gBuffer->push_back(record);
+  if (gBuffer->size() == kBufferSize) Flush();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhaseSpaceWriter::Flush() {
+  if (!gBuffer || gBuffer->empty()) return;
+
+  G4AutoLock lock(&fMutex);
+  if (fIsOpen) {
+    fFile.write(reinterpret_cast<const char *>(gBuffer->data()),
+                gBuffer->size() * sizeof(PhaseSpaceRecord));
+    fNofRecords += gBuffer->size();
+  }
+  gBuffer->clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhaseSpaceWriter::Close() {
+  Flush();
+
+  G4AutoLock lock(&fMutex);
+  if (!fIsOpen) return;
+  fFile.close();
+  fIsOpen = false;
+  G4cout << " Phase space: " << fNofRecords << " neutrons written" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhaseSpaceReader *PhaseSpaceReader::Instance() {
+  static PhaseSpaceReader instance;
+  return &instance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhaseSpaceReader::Load(const G4String &fileName) {
+  G4AutoLock lock(&fMutex);
+  if (fileName == fFileName) return;
+
+  std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+  char magic[sizeof(kMagic)] = {};
+  std::size_t fileSize = file ? std::size_t(file.tellg()) : 0;
+  file.seekg(0);
+  file.read(magic, sizeof(magic));
+  if (!file || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+    G4ExceptionDescription msg;
+    msg << "Cannot read phase space file " << fileName;
+    G4Exception("PhaseSpaceReader::Load()", "MyCode0005", FatalException,
+                msg);
+  }
+
+  auto dataSize = fileSize - sizeof(kMagic);
+  if (dataSize % sizeof(PhaseSpaceRecord) != 0) {
+    G4ExceptionDescription msg;
+    msg << "Phase space file " << fileName << " is truncated: the last "
+        << dataSize % sizeof(PhaseSpaceRecord)
+        << " bytes, an incomplete record, are ignored.";
+    G4Exception("PhaseSpaceReader::Load()", "MyCode0005", JustWarning, msg);
+  }
+  fRecords.resize(dataSize / sizeof(PhaseSpaceRecord));
+  file.read(reinterpret_cast<char *>(fRecords.data()),
+            fRecords.size() * sizeof(PhaseSpaceRecord));
+  fFileName = fileName;
+  fNextIndex = 0;
+
+  G4cout << " Phase space: " << fRecords.size() << " neutrons read from "
+         << fileName << G4endl;
+  if (fRecords.empty()) {
+    G4Exception("PhaseSpaceReader::Load()", "MyCode0005", FatalException,
+                "Empty phase space file");
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::size_t PhaseSpaceReader::NextIndex() {
+  auto index = fNextIndex++;
+  if (index == fRecords.size()) {
+    G4Exception("PhaseSpaceReader::NextIndex()", "MyCode0006", JustWarning,
+                "End of the phase space file reached, restarting from the "
+                "first record");
+  }
+  return index % fRecords.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
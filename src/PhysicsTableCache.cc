@@ -0,0 +1,218 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/PhysicsTableCache.cc
+/// \brief Implementation of the B4d::PhysicsTableCache class
+
+#include "PhysicsTableCache.hh"
+
+#include "G4EmParameters.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Material.hh"
+#include "G4ProductionCuts.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4StateManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4VUserPhysicsList.hh"
+#include "G4Version.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+const char *kKeyFileName = "B4_tables.key";
+
+// 64-bit FNV-1a hash, stable from one build to the other
+std::uint64_t Hash(const std::string &text) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+} // namespace
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhysicsTableCache::PhysicsTableCache(G4VUserPhysicsList *physicsList,
+                                     const G4String &physicsListName)
+    : fPhysicsList(physicsList), fPhysicsListName(physicsListName) {
+  fMessenger =
+      new G4GenericMessenger(this, "/B4/physics/", "Physics tables");
+
+  auto &cacheCmd = fMessenger->DeclareProperty(
+      "tableCache", fCacheDirectory,
+      "Store the physics tables in the directory at the first run, and\n"
+      "retrieve them from it at the next starts with the same physics\n"
+      "list, cuts and materials.");
+  cacheCmd.SetParameterName("directory", false);
+  cacheCmd.SetStates(G4State_PreInit);
+  cacheCmd.SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhysicsTableCache::~PhysicsTableCache() { delete fMessenger; }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PhysicsTableCache::Notify(G4ApplicationState requestedState) {
+  if (fIsDone || fCacheDirectory.empty()) return true;
+
+  // the current state is still the previous one; the run initialization
+  // goes from Idle to Init just before building the tables, when the cuts
+  // set after /run/initialize are known, and closes the geometry after
+  auto state = G4StateManager::GetStateManager()->GetCurrentState();
+  if (state == G4State_Idle && requestedState == G4State_Init &&
+      !fIsPrepared) {
+    Prepare();
+  } else if (requestedState == G4State_GeomClosed && fIsPrepared) {
+    Finish();
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String PhysicsTableCache::MakeKey() const {
+  std::ostringstream key;
+  key << std::setprecision(10);
+  key << "physicsList " << fPhysicsListName << "\n"
+      << "geant4 " << G4VERSION_NUMBER << "\n"
+      << "defaultCut " << fPhysicsList->GetDefaultCutValue() / mm << "\n";
+
+  for (const auto region : *G4RegionStore::GetInstance()) {
+    key << "region " << region->GetName();
+    auto cuts = region->GetProductionCuts();
+    if (cuts) {
+      for (auto cut : cuts->GetProductionCuts()) key << " " << cut / mm;
+    }
+    key << "\n";
+  }
+
+  for (const auto material : *G4Material::GetMaterialTable()) {
+    key << "material " << material->GetName() << " "
+        << material->GetDensity() / (g / cm3);
+    auto fractions = material->GetFractionVector();
+    for (std::size_t i = 0; i < material->GetNumberOfElements(); ++i) {
+      key << " " << material->GetElement(G4int(i))->GetZ() << ":"
+          << fractions[i];
+    }
+    key << "\n";
+  }
+
+  // the EM options and the data sets change the tables too
+  G4EmParameters::Instance()->StreamInfo(key);
+  for (auto variable : {"G4LEDATA", "G4LEVELGAMMADATA", "G4NEUTRONHPDATA",
+                        "G4PARTICLEXSDATA", "G4ENSDFSTATEDATA",
+                        "G4SAIDXSDATA", "G4ABLADATA", "G4INCLDATA",
+                        "G4PIIDATA", "G4REALSURFACEDATA",
+                        "G4RADIOACTIVEDATA"}) {
+    auto path = std::getenv(variable);
+    key << "data " << variable << " " << (path ? path : "") << "\n";
+  }
+  return key.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String PhysicsTableCache::GetTableDirectory(const G4String &key) const {
+  std::ostringstream directory;
+  directory << fCacheDirectory << "/" << std::hex << std::setw(16)
+            << std::setfill('0') << Hash(key);
+  return directory.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsTableCache::Prepare() {
+  fIsPrepared = true;
+  fKey = MakeKey();
+  fTableDirectory = GetTableDirectory(fKey);
+
+  std::ifstream keyFile(fTableDirectory + "/" + kKeyFileName);
+  std::ostringstream storedKey;
+  storedKey << keyFile.rdbuf();
+  fIsRetrieved = keyFile && (storedKey.str() == fKey);
+
+  if (fIsRetrieved) {
+    fPhysicsList->SetPhysicsTableRetrieved(fTableDirectory);
+    G4cout << " Physics tables: retrieved from " << fTableDirectory
+           << G4endl;
+  } else {
+    G4cout << " Physics tables: not in the cache, they will be stored in "
+           << fTableDirectory << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsTableCache::Finish() {
+  fIsDone = true;
+
+  if (fIsRetrieved) {
+    fPhysicsList->ResetPhysicsTableRetrieved();
+    return;
+  }
+
+  // the tables are stored with the key of the closed geometry, with the
+  // production cuts of the regions as used to build them
+  auto key = MakeKey();
+  if (key != fKey) {
+    fKey = key;
+    fTableDirectory = GetTableDirectory(fKey);
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(fTableDirectory.c_str(), error);
+  if (error || !fPhysicsList->StorePhysicsTable(fTableDirectory)) {
+    G4ExceptionDescription msg;
+    msg << "Cannot store the physics tables in " << fTableDirectory;
+    G4Exception("PhysicsTableCache::Finish()", "MyCode0012", JustWarning,
+                msg);
+    return;
+  }
+
+  // the key is written last, so that an interrupted store is not used
+  std::ofstream keyFile(fTableDirectory + "/" + kKeyFileName);
+  keyFile << fKey;
+  G4cout << " Physics tables: stored in " << fTableDirectory << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
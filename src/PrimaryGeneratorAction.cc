@@ -1,58 +1,255 @@
 
 
 #include "PrimaryGeneratorAction.hh"
+#include "PhaseSpace.hh"
+#include "StackingAction.hh"
 
 #include "G4Box.hh"
+#include "G4DynamicParticle.hh"
 #include "G4Event.hh"
 #include "G4LogicalVolume.hh"
 #include "G4LogicalVolumeStore.hh"
 #include "G4ParticleDefinition.hh"
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
 #include "Randomize.hh"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+// Reseed the engine with two seeds derived from the event seed and the event
+// ID (splitmix64), positive and not 0 as expected by G4Random::setTheSeeds()
+void SetEventSeeds(G4int eventSeed, G4int eventID) {
+  auto state = (std::uint64_t(eventSeed) << 32) ^ std::uint32_t(eventID);
+  auto next = [&state]() {
+    state += 0x9E3779B97F4A7C15ULL;
+    auto z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return long((z ^ (z >> 31)) >> 34) + 1;
+  };
+  long seeds[3] = {next(), next(), 0};
+  G4Random::setTheSeeds(seeds);
+}
+
+} // namespace
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 namespace B4 {
-PrimaryGeneratorAction::PrimaryGeneratorAction() {
+PrimaryGeneratorAction::PrimaryGeneratorAction(
+    const GunParameters *parameters,
+    const B4d::PhaseSpaceParameters *phaseSpaceParameters,
+    const B4d::StackingParameters *stackingParameters)
+    : fParameters(parameters), fPhaseSpaceParameters(phaseSpaceParameters),
+      fStackingParameters(stackingParameters) {
   fParticleGun = new G4ParticleGun(0);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-PrimaryGeneratorAction::~PrimaryGeneratorAction() { delete fParticleGun; }
+PrimaryGeneratorAction::~PrimaryGeneratorAction() {
+  ClearPendingBatches();
+  delete fParticleGun;
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event *anEvent) {
-  G4int n_particlePo = 4200;
-  G4int n_particlePi = 2200;
-  G4int n_particlePr = 1100;
+  if (fParameters->eventSeed != 0) {
+    SetEventSeeds(fParameters->eventSeed, anEvent->GetEventID());
+  }
+  // the batches left by an aborted event
+  ClearPendingBatches();
+
+  if (!fPhaseSpaceParameters->inputFile.empty()) {
+    if (fStackingParameters->primariesPerStage > 0 && !fStagingRefused) {
+      G4Exception("PrimaryGeneratorAction::GeneratePrimaries()", "MyCode0015",
+                  JustWarning,
+                  "The staged primary injection does not apply to the phase "
+                  "space input:\nall the primaries of an event are generated "
+                  "at once.");
+      fStagingRefused = true;
+    }
+    GeneratePhaseSpacePrimaries(anEvent);
+    return;
+  }
+
+  fParticleGun->SetParticlePosition(G4ThreeVector(-1 * m, 0. * cm, 0. * m));
+  fParticleGun->SetParticleMomentumDirection(G4ThreeVector(1., 0., 0.));
+  fParticleGun->SetParticleMomentum(fParameters->momentum);
+
+  // single species mode: one primary
+  if (fParameters->species != "bunch") {
+    fParticleGun->SetNumberOfParticles(1);
+    fParticleGun->SetParticleDefinition(
+        G4ParticleTable::GetParticleTable()->FindParticle(
+            fParameters->species));
+    fParticleGun->GeneratePrimaryVertex(anEvent);
+    return;
+  }
+
+  G4int n_particlePo = fParameters->nofPositrons;
+  G4int n_particlePi = fParameters->nofPions;
+  G4int n_particlePr = fParameters->nofProtons;
+  G4int n_particleNe = fParameters->nofNeutrons;
   // 1 GeV 5700 1100 1100 Sum: 7900
   // 1.5 GeV 4200 2200 1100 Sum: 7500
   // 2 GeV 3100 3700 1100 Sum: 7900
 
+  // sub-event mode: keep only this chunk of the bunch
+  auto nofChunks = fParameters->chunksPerBunch;
+  if (nofChunks > 1) {
+    auto chunk = anEvent->GetEventID() % nofChunks;
+    auto chunkSize = [=](G4int n) {
+      return n * (chunk + 1) / nofChunks - n * chunk / nofChunks;
+    };
+    n_particlePo = chunkSize(n_particlePo);
+    n_particlePi = chunkSize(n_particlePi);
+    n_particlePr = chunkSize(n_particlePr);
+    n_particleNe = chunkSize(n_particleNe);
+  }
+
   G4ParticleDefinition *po =
       G4ParticleTable::GetParticleTable()->FindParticle("e+");
   G4ParticleDefinition *pi =
       G4ParticleTable::GetParticleTable()->FindParticle("pi+");
   G4ParticleDefinition *pr =
       G4ParticleTable::GetParticleTable()->FindParticle("proton");
-  fParticleGun->SetParticlePosition(G4ThreeVector(-1 * m, 0. * cm, 0. * m));
-  fParticleGun->SetParticleMomentumDirection(G4ThreeVector(1., 0., 0.));
+  G4ParticleDefinition *ne =
+      G4ParticleTable::GetParticleTable()->FindParticle("neutron");
+  Bunch bunch = {{po, n_particlePo}, {pi, n_particlePi}, {pr, n_particlePr}};
+  // optional neutrons
+  if (n_particleNe > 0) bunch.emplace_back(ne, n_particleNe);
+
+  if (fStackingParameters->primariesPerStage > 0) {
+    GenerateStagedPrimaries(anEvent, bunch);
+    return;
+  }
+
+  for (const auto &[particle, n] : bunch) {
+    fParticleGun->SetParticleDefinition(particle);
+    fParticleGun->SetNumberOfParticles(n);
+    fParticleGun->GeneratePrimaryVertex(anEvent);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::GenerateStagedPrimaries(G4Event *anEvent,
+                                                     const Bunch &bunch) {
+  // the batches follow the order of generation of the bunch, with one
+  // vertex per species in each batch
+  auto batchSize = fStackingParameters->primariesPerStage;
+  std::vector<G4PrimaryVertex *> batch;
+  G4int nofInBatch = 0;
+  for (auto [particle, n] : bunch) {
+    while (n > 0) {
+      auto nofInVertex = std::min(n, batchSize - nofInBatch);
+      batch.push_back(CreateVertex(particle, nofInVertex));
+      n -= nofInVertex;
+      nofInBatch += nofInVertex;
+      if (nofInBatch == batchSize) {
+        fPendingBatches.push_back(std::move(batch));
+        batch.clear();
+        nofInBatch = 0;
+      }
+    }
+  }
+  if (!batch.empty()) fPendingBatches.push_back(std::move(batch));
+
+  // the first batch is tracked from the start of the event
+  if (fNextBatch < fPendingBatches.size()) {
+    for (auto vertex : fPendingBatches[fNextBatch]) {
+      anEvent->AddPrimaryVertex(vertex);
+    }
+    ++fNextBatch;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4PrimaryVertex *
+PrimaryGeneratorAction::CreateVertex(G4ParticleDefinition *particle,
+                                     G4int n) const {
+  // same kinematics as the vertices of the particle gun
+  auto vertex = new G4PrimaryVertex(fParticleGun->GetParticlePosition(),
+                                    fParticleGun->GetParticleTime());
+  auto momentum =
+      fParticleGun->GetParticleMomentumDirection() * fParameters->momentum;
+  for (G4int i = 0; i < n; ++i) {
+    vertex->SetPrimary(new G4PrimaryParticle(particle, momentum.x(),
+                                             momentum.y(), momentum.z()));
+  }
+  return vertex;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::ReleasePrimaries(G4Event *anEvent,
+                                              G4TrackVector &tracks) {
+  if (fNextBatch >= fPendingBatches.size()) return;
+
+  // the tracks are created as by G4PrimaryTransformer; the event manager
+  // sets their IDs, and the ones of their primaries, when they are stacked
+  for (auto vertex : fPendingBatches[fNextBatch]) {
+    anEvent->AddPrimaryVertex(vertex);
+    for (auto primary = vertex->GetPrimary(); primary != nullptr;
+         primary = primary->GetNext()) {
+      auto dynamicParticle =
+          new G4DynamicParticle(primary->GetG4code(), primary->GetMomentum());
+      dynamicParticle->SetPrimaryParticle(primary);
+      auto track = new G4Track(dynamicParticle, vertex->GetT0(),
+                               vertex->GetPosition());
+      track->SetParentID(0);
+      track->SetWeight(primary->GetWeight());
+      tracks.push_back(track);
+    }
+  }
+  ++fNextBatch;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::ClearPendingBatches() {
+  // the released vertices belong to their event
+  for (auto i = fNextBatch; i < fPendingBatches.size(); ++i) {
+    for (auto vertex : fPendingBatches[i]) delete vertex;
+  }
+  fPendingBatches.clear();
+  fNextBatch = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-  fParticleGun->SetParticleMomentum(1.5 * GeV);
+void PrimaryGeneratorAction::GeneratePhaseSpacePrimaries(G4Event *anEvent) {
+  // the file is loaded by the master at the beginning of run
+  auto reader = B4d::PhaseSpaceReader::Instance();
+  const auto &records = reader->GetRecords();
+  auto resample = (fPhaseSpaceParameters->mode == "resample");
+  auto neutron = G4ParticleTable::GetParticleTable()->FindParticle("neutron");
 
-  fParticleGun->SetNumberOfParticles(n_particlePo);
-  fParticleGun->SetParticleDefinition(po);
-  fParticleGun->GeneratePrimaryVertex(anEvent);
+  for (G4int i = 0; i < fPhaseSpaceParameters->neutronsPerEvent; ++i) {
+    auto index = resample ? std::size_t(G4UniformRand() * records.size())
+                          : reader->NextIndex();
+    const auto &record = records[std::min(index, records.size() - 1)];
 
-  fParticleGun->SetParticleDefinition(pi);
-  fParticleGun->SetNumberOfParticles(n_particlePi);
-  fParticleGun->GeneratePrimaryVertex(anEvent);
-  fParticleGun->SetParticleDefinition(pr);
-  fParticleGun->SetNumberOfParticles(n_particlePr);
-  fParticleGun->GeneratePrimaryVertex(anEvent);
+    auto vertex = new G4PrimaryVertex(
+        G4ThreeVector(record.x, record.y, record.z) * mm, record.time * ns);
+    auto particle = new G4PrimaryParticle(neutron);
+    particle->SetKineticEnergy(record.kinEnergy * MeV);
+    particle->SetMomentumDirection(
+        G4ThreeVector(record.dx, record.dy, record.dz));
+    particle->SetWeight(record.weight);
+    vertex->SetPrimary(particle);
+    anEvent->AddPrimaryVertex(vertex);
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
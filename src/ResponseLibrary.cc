@@ -0,0 +1,261 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/ResponseLibrary.cc
+/// \brief Implementation of the B4d::ResponseLibrary class
+
+#include "ResponseLibrary.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseLibrary *ResponseLibrary::Instance() {
+  static ResponseLibrary instance;
+  return &instance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::SetFileName(const G4String &fileName) {
+  fFileName = fileName;
+  fIsLoaded = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseLibrary::Response *ResponseLibrary::Find(const G4String &species,
+                                                 G4double momentum) {
+  for (auto &response : fResponses) {
+    if (response.species == species &&
+        std::abs(response.momentum - momentum) < 1.e-6 * momentum) {
+      return &response;
+    }
+  }
+  return nullptr;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::Load() {
+  fIsLoaded = true;
+  fSetup.clear();
+  fDetectorNames.clear();
+  fResponses.clear();
+
+  // a missing file is an empty library
+  std::ifstream file(fFileName);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream is(line);
+    std::string key;
+    is >> key;
+    if (key == "setup") {
+      std::getline(is >> std::ws, fSetup);
+    } else if (key == "detectors") {
+      std::string name;
+      while (is >> name) fDetectorNames.push_back(name);
+    } else if (key == "response") {
+      Response response;
+      std::string species;
+      is >> species >> response.momentum >> response.nofEvents;
+      response.species = species;
+      response.momentum *= MeV;
+      auto n = fDetectorNames.size();
+      response.mean.resize(n);
+      response.covariance.resize(n * n);
+      for (auto &value : response.mean) is >> value;
+      for (auto &value : response.covariance) is >> value;
+      if (is.fail()) {
+        G4ExceptionDescription msg;
+        msg << "Invalid response in " << fFileName << ": " << line;
+        G4Exception("ResponseLibrary::Load()", "MyCode0010", JustWarning,
+                    msg);
+        continue;
+      }
+      fResponses.push_back(response);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::Save() const {
+  std::ofstream file(fFileName);
+  if (!file) {
+    G4ExceptionDescription msg;
+    msg << "Cannot write response library " << fFileName;
+    G4Exception("ResponseLibrary::Save()", "MyCode0010", JustWarning, msg);
+    return;
+  }
+
+  file << "# B4 detector response per primary: species, momentum (MeV),"
+       << " number of events, mean, covariance (row-major)\n"
+       << "setup " << fSetup << '\n'
+       << "detectors";
+  for (const auto &name : fDetectorNames) file << ' ' << name;
+  file << '\n' << std::setprecision(10);
+  for (const auto &response : fResponses) {
+    file << "response " << response.species << ' ' << response.momentum / MeV
+         << ' ' << response.nofEvents;
+    for (auto value : response.mean) file << ' ' << value;
+    for (auto value : response.covariance) file << ' ' << value;
+    file << '\n';
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::Add(const G4String &species, G4double momentum,
+                          const G4String &setup,
+                          const std::vector<G4String> &detectorNames,
+                          G4int nofEvents, const std::vector<G4double> &sums,
+                          const std::vector<G4double> &products) {
+  // the covariance needs 2 events at least
+  if (nofEvents < 2) {
+    G4ExceptionDescription msg;
+    msg << "The response of " << species << " at " << momentum / GeV
+        << " GeV/c needs 2 events at least, the run of " << nofEvents
+        << " event(s) is not added to " << fFileName;
+    G4Exception("ResponseLibrary::Add()", "MyCode0010", JustWarning, msg);
+    return;
+  }
+  if (!fIsLoaded) Load();
+
+  // the responses of another detector setup cannot be pooled nor combined
+  if (fResponses.empty()) {
+    fSetup = setup;
+    fDetectorNames = detectorNames;
+  } else if (setup != fSetup || detectorNames != fDetectorNames) {
+    G4ExceptionDescription msg;
+    msg << "The detector setup differs from the one of " << fFileName
+        << ":\n  " << setup << "\ninstead of\n  " << fSetup
+        << "\nthe response of " << species << " at " << momentum / GeV
+        << " GeV/c is not added; use another library file";
+    G4Exception("ResponseLibrary::Add()", "MyCode0010", JustWarning, msg);
+    return;
+  }
+
+  // pool with the previous runs: back to the sums
+  auto n = sums.size();
+  auto totalSums = sums;
+  auto totalProducts = products;
+  G4int totalEvents = nofEvents;
+  auto response = Find(species, momentum);
+  if (response) {
+    auto m = response->nofEvents;
+    for (std::size_t i = 0; i < n; ++i) {
+      totalSums[i] += m * response->mean[i];
+      for (std::size_t j = 0; j < n; ++j) {
+        totalProducts[i * n + j] +=
+            (m - 1) * response->covariance[i * n + j] +
+            m * response->mean[i] * response->mean[j];
+      }
+    }
+    totalEvents += m;
+  } else {
+    fResponses.push_back({species, momentum, 0, {}, {}});
+    response = &fResponses.back();
+  }
+
+  response->nofEvents = totalEvents;
+  response->mean.resize(n);
+  response->covariance.resize(n * n);
+  for (std::size_t i = 0; i < n; ++i) {
+    response->mean[i] = totalSums[i] / totalEvents;
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) {
+      response->covariance[i * n + j] =
+          (totalProducts[i * n + j] -
+           totalEvents * response->mean[i] * response->mean[j]) /
+          (totalEvents - 1);
+    }
+  }
+  Save();
+
+  G4cout << " Response of " << species << " at "
+         << momentum / GeV << " GeV/c: " << totalEvents
+         << " primaries, saved in " << fFileName << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::Combine(G4double momentum, G4int nofPositrons,
+                              G4int nofPions, G4int nofProtons) {
+  auto start = std::chrono::steady_clock::now();
+  if (!fIsLoaded) Load();
+
+  auto n = fDetectorNames.size();
+  std::vector<G4double> mean(n, 0.);
+  std::vector<G4double> covariance(n * n, 0.);
+  const std::pair<const char *, G4int> composition[] = {
+      {"e+", nofPositrons}, {"pi+", nofPions}, {"proton", nofProtons}};
+  for (const auto &[species, nofPrimaries] : composition) {
+    if (nofPrimaries == 0) continue;
+    auto response = Find(species, momentum);
+    if (!response) {
+      G4ExceptionDescription msg;
+      msg << "No response of " << species << " at " << momentum / GeV
+          << " GeV/c in " << fFileName;
+      G4Exception("ResponseLibrary::Combine()", "MyCode0010", JustWarning,
+                  msg);
+      return;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      mean[i] += nofPrimaries * response->mean[i];
+    }
+    for (std::size_t i = 0; i < n * n; ++i) {
+      covariance[i] += nofPrimaries * response->covariance[i];
+    }
+  }
+  std::chrono::duration<G4double, std::milli> time =
+      std::chrono::steady_clock::now() - start;
+
+  G4cout << " Bunch response of " << nofPositrons << " e+, " << nofPions
+         << " pi+, " << nofProtons << " protons at " << momentum / GeV
+         << " GeV/c (" << time.count() << " ms)," << G4endl
+         << " setup: " << fSetup << ":" << G4endl;
+  for (std::size_t i = 0; i < n; ++i) {
+    G4cout << "   " << std::setw(9) << fDetectorNames[i] << ": "
+           << std::setw(12) << mean[i] << " +- "
+           << std::sqrt(std::max(0., covariance[i * n + i])) << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
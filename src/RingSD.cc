@@ -0,0 +1,94 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/RingSD.cc
+/// \brief Implementation of the B4d::RingSD class
+
+#include "RingSD.hh"
+#include "Run.hh"
+#include "TrackInformation.hh"
+
+#include "G4Neutron.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4VTouchable.hh"
+
+#include <algorithm>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RingSD::RingSD(const G4String &name, G4int nofDetectors)
+    : G4VSensitiveDetector(name), fCounts(nofDetectors, 0.),
+      fNeutron(G4Neutron::Definition()) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RingSD::SetNofDetectors(G4int nofDetectors) {
+  fCounts.assign(nofDetectors, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String RingSD::GetDetectorName(G4int copyNo) {
+  return (copyNo == 0) ? G4String("Gap") : "Gap" + std::to_string(copyNo + 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RingSD::Initialize(G4HCofThisEvent * /*hce*/) {
+  std::fill(fCounts.begin(), fCounts.end(), 0.);
+  fRun = static_cast<Run *>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RingSD::ProcessHits(G4Step *step, G4TouchableHistory * /*history*/) {
+  if (step->GetTrack()->GetDefinition() != fNeutron) return false;
+
+  // count the step entering the detector
+  auto preStepPoint = step->GetPreStepPoint();
+  if (preStepPoint->GetStepStatus() != fGeomBoundary) return false;
+
+  auto copyNo = preStepPoint->GetTouchable()->GetCopyNumber();
+  auto weight = preStepPoint->GetWeight();
+  fCounts[copyNo] += weight;
+
+  // attribution to the species of the primary
+  auto info = static_cast<const TrackInformation *>(
+      step->GetTrack()->GetUserInformation());
+  fRun->AddOriginCount(copyNo, info ? info->GetOriginSpecies() : Run::kOther,
+                       weight);
+  fRun->FillSpectra(copyNo, preStepPoint->GetKineticEnergy(),
+                    preStepPoint->GetGlobalTime(), weight);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,342 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/Run.cc
+/// \brief Implementation of the B4d::Run class
+
+#include "Run.hh"
+#include "RingSD.hh"
+
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4Neutron.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4PionMinus.hh"
+#include "G4PionPlus.hh"
+#include "G4Positron.hh"
+#include "G4Proton.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UnitsTable.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int Run::GetSpecies(const G4ParticleDefinition *particle) {
+  if (particle == G4Gamma::Definition()) return kGamma;
+  if (particle == G4Electron::Definition()) return kElectron;
+  if (particle == G4Positron::Definition()) return kPositron;
+  if (particle == G4Neutron::Definition()) return kNeutron;
+  if (particle == G4Proton::Definition()) return kProton;
+  if (particle == G4PionPlus::Definition() ||
+      particle == G4PionMinus::Definition())
+    return kPion;
+  return kOther;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char *Run::GetSpeciesName(G4int species) {
+  static const char *names[kNofSpecies] = {"gamma",  "e-", "e+",   "neutron",
+                                           "proton", "pi", "other"};
+  return names[species];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+// add the values of the second vector to the first one, resized if needed
+void Accumulate(std::vector<G4double> &sums,
+                const std::vector<G4double> &values) {
+  if (sums.size() < values.size()) sums.resize(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i) sums[i] += values[i];
+}
+
+// print the number and the energy of killed tracks per species
+void PrintKilledTracks(
+    const std::array<G4int, Run::kNofSpecies> &nofTracks,
+    const std::array<G4double, Run::kNofSpecies> &energy) {
+  for (G4int i = 0; i < Run::kNofSpecies; ++i) {
+    if (nofTracks[i] == 0) continue;
+    G4cout << "   " << std::setw(8) << Run::GetSpeciesName(i) << ": "
+           << std::setw(10) << nofTracks[i] << " tracks, "
+           << G4BestUnit(energy[i], "Energy") << G4endl;
+  }
+}
+
+} // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Run::GetRelativeError(G4double sum, G4double sum2, G4int n) {
+  if (sum <= 0. || n < 2) return 0.;
+  return std::sqrt(std::max(0., sum2 / (sum * sum) - 1. / n));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::SetLambertianApproximation(
+    const LambertianApproximation &approximation) {
+  auto n = approximation.GetNofDetectors();
+  fLambertian = approximation;
+  fLambertianScores.assign(n, 0.);
+  fLambertianSums.assign(n, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::BookOriginCounts(G4int nofRingDetectors) {
+  fOriginCounts.assign(nofRingDetectors * kNofSpecies, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::BookSpectra(G4int nofRingDetectors) {
+  fSpectra.Book(nofRingDetectors + 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::RecordEvent(const G4Event *event) {
+  for (std::size_t i = 0; i < fLambertianScores.size(); ++i) {
+    fLambertianSums[i] += fLambertianScores[i];
+    fLambertianScores[i] = 0.;
+  }
+  fMaxPeakStackDepth = std::max(fMaxPeakStackDepth, fEventPeakStackDepth);
+  fSumPeakStackDepth += fEventPeakStackDepth;
+  fEventPeakStackDepth = 0;
+  fMaxPeakUrgentDepth = std::max(fMaxPeakUrgentDepth, fEventPeakUrgentDepth);
+  fSumPeakUrgentDepth += fEventPeakUrgentDepth;
+  fEventPeakUrgentDepth = 0;
+
+  G4Run::RecordEvent(event);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::Merge(const G4Run *run) {
+  auto localRun = static_cast<const Run *>(run);
+  for (G4int i = 0; i < kNofSpecies; ++i) {
+    fKilledTracks[i] += localRun->fKilledTracks[i];
+    fKilledEnergy[i] += localRun->fKilledEnergy[i];
+    fZoneKilledTracks[i] += localRun->fZoneKilledTracks[i];
+    fZoneKilledEnergy[i] += localRun->fZoneKilledEnergy[i];
+  }
+  for (G4int i = 0; i < kNofKillReasons; ++i) {
+    fZoneKillReasons[i] += localRun->fZoneKillReasons[i];
+  }
+  Accumulate(fRingCounts, localRun->fRingCounts);
+  Accumulate(fRingCounts2, localRun->fRingCounts2);
+  Accumulate(fOriginCounts, localRun->fOriginCounts);
+  Accumulate(fLambertianSums, localRun->fLambertianSums);
+  fMaxPeakStackDepth =
+      std::max(fMaxPeakStackDepth, localRun->fMaxPeakStackDepth);
+  fSumPeakStackDepth += localRun->fSumPeakStackDepth;
+  fMaxPeakUrgentDepth =
+      std::max(fMaxPeakUrgentDepth, localRun->fMaxPeakUrgentDepth);
+  fSumPeakUrgentDepth += localRun->fSumPeakUrgentDepth;
+  fNofSteps += localRun->fNofSteps;
+  fNofFastShowers += localRun->fNofFastShowers;
+  fFastShowerEnergy += localRun->fFastShowerEnergy;
+  fNofFastNeutrons += localRun->fNofFastNeutrons;
+  fNofResponses += localRun->fNofResponses;
+  Accumulate(fResponseSums, localRun->fResponseSums);
+  Accumulate(fResponseProducts, localRun->fResponseProducts);
+  fNofSplitTracks += localRun->fNofSplitTracks;
+  fNofRouletteSurvived += localRun->fNofRouletteSurvived;
+  fNofRouletteKilled += localRun->fNofRouletteKilled;
+  fSpectra.Merge(localRun->fSpectra);
+  fStepProfile.Merge(localRun->fStepProfile);
+
+  G4Run::Merge(run);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int Run::GetNofKilledTracks() const {
+  G4int nofKilled = 0;
+  for (auto n : fKilledTracks) nofKilled += n;
+  return nofKilled;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int Run::GetNofZoneKilledTracks() const {
+  G4int nofKilled = 0;
+  for (auto n : fZoneKilledTracks) nofKilled += n;
+  return nofKilled;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintStackingStatistics() const {
+  G4cout << " Tracks killed by the stacking action: " << GetNofKilledTracks()
+         << G4endl;
+  PrintKilledTracks(fKilledTracks, fKilledEnergy);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintKillZoneStatistics() const {
+  if (GetNofZoneKilledTracks() == 0) return;
+
+  G4cout << " Tracks killed in the kill zone: " << GetNofZoneKilledTracks()
+         << " (outside the envelope: " << fZoneKillReasons[kOutsideEnvelope]
+         << ", time cut: " << fZoneKillReasons[kTimeCut]
+         << ", energy cut: " << fZoneKillReasons[kEnergyCut] << ")" << G4endl;
+  PrintKilledTracks(fZoneKilledTracks, fZoneKilledEnergy);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintRingCounts() const {
+  G4cout << " Neutrons entering the ring detectors:" << G4endl;
+  auto nofEvents = GetNumberOfEvent();
+  for (std::size_t i = 0; i < fRingCounts.size(); ++i) {
+    G4cout << "   " << std::setw(6) << RingSD::GetDetectorName(G4int(i))
+           << ": " << std::setw(12) << fRingCounts[i] << " +- " << std::setw(6)
+           << 100. * GetRelativeError(fRingCounts[i], fRingCounts2[i],
+                                      nofEvents)
+           << " %" << G4endl;
+  }
+
+  // the Lambertian approximation is not an estimate of the counts (see
+  // LambertianApproximation): it is printed apart, with its ratio to them
+  G4cout << " Lambertian approximation of the ring counts (cosine exit"
+         << " distribution assumed," << G4endl
+         << " not an estimate of the counts):" << G4endl;
+  for (std::size_t i = 0; i < fLambertianSums.size(); ++i) {
+    auto analog = (i < fRingCounts.size()) ? fRingCounts[i] : 0.;
+    G4cout << "   " << std::setw(6) << RingSD::GetDetectorName(G4int(i))
+           << ": " << std::setw(12) << fLambertianSums[i];
+    if (analog > 0.) {
+      G4cout << "  (" << fLambertianSums[i] / analog << " x the counts)";
+    }
+    G4cout << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintOriginCounts() const {
+  // only the species of the primaries of the run
+  std::array<G4double, kNofSpecies> totals{};
+  for (std::size_t i = 0; i < fOriginCounts.size(); ++i) {
+    totals[i % kNofSpecies] += fOriginCounts[i];
+  }
+  if (std::all_of(totals.begin(), totals.end(),
+                  [](G4double total) { return total == 0.; })) {
+    return;
+  }
+
+  G4cout << " Neutrons entering the ring detectors per primary species:"
+         << G4endl << "   " << std::setw(6) << "" << "  ";
+  for (G4int j = 0; j < kNofSpecies; ++j) {
+    if (totals[j] > 0.) G4cout << std::setw(12) << GetSpeciesName(j);
+  }
+  G4cout << G4endl;
+  auto nofDetectors = G4int(fOriginCounts.size()) / kNofSpecies;
+  for (G4int i = 0; i < nofDetectors; ++i) {
+    G4cout << "   " << std::setw(6) << RingSD::GetDetectorName(i) << ": ";
+    for (G4int j = 0; j < kNofSpecies; ++j) {
+      if (totals[j] > 0.) {
+        G4cout << std::setw(12) << fOriginCounts[i * kNofSpecies + j];
+      }
+    }
+    G4cout << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintStackDepth() const {
+  auto nofEvents = GetNumberOfEvent();
+  if (nofEvents == 0) return;
+  G4cout << " Peak track stack depth: " << fSumPeakStackDepth / nofEvents
+         << " per event on average, " << fMaxPeakStackDepth << " at most"
+         << G4endl
+         << " Peak urgent stack depth: " << fSumPeakUrgentDepth / nofEvents
+         << " per event on average, " << fMaxPeakUrgentDepth << " at most"
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintFastShowerStatistics() const {
+  if (fNofFastShowers == 0) return;
+
+  G4cout << " Showers parameterized in the Target: " << fNofFastShowers
+         << ", " << G4BestUnit(fFastShowerEnergy, "Energy") << ", "
+         << fNofFastNeutrons << " neutrons produced ("
+         << fNofFastNeutrons / (fFastShowerEnergy / GeV) << " per GeV)"
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintBiasingStatistics() const {
+  if (!IsBiased()) return;
+
+  G4cout << " Neutron weight window in the Target: " << fNofSplitTracks
+         << " copies added by splitting, " << fNofRouletteSurvived
+         << " survived and " << fNofRouletteKilled << " killed by roulette"
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::WriteSpectra(const G4String &fileName) const {
+  std::vector<G4String> detectorNames;
+  for (G4int i = 0; i < fSpectra.GetNofDetectors() - 1; ++i) {
+    detectorNames.push_back(RingSD::GetDetectorName(i));
+  }
+  detectorNames.push_back("NDet");
+  fSpectra.Write(fileName, detectorNames);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::PrintStepProfile() const {
+  if (fStepProfile.IsEmpty()) return;
+  fStepProfile.Print(20);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::WriteStepProfile(const G4String &fileName) const {
+  if (fStepProfile.IsEmpty()) return;
+  fStepProfile.Write(fileName);
+  G4cout << " Step profile written in " << fileName << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
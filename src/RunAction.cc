@@ -28,18 +28,171 @@
 /// \brief Implementation of the B4::RunAction class
 
 #include "RunAction.hh"
+#include "BunchMerger.hh"
+#include "ConvergenceMonitor.hh"
+#include "DetectorConstruction.hh"
+#include "EventAction.hh"
+#include "PhaseSpace.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "ResponseLibrary.hh"
+#include "RingSD.hh"
+#include "Run.hh"
+#include "WorkerTimeline.hh"
 
 #include "G4AnalysisManager.hh"
 #include "G4Run.hh"
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
 #include "G4UnitsTable.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Memory of the process in MB, read from /proc/self/status: VmRSS for the
+// resident set size, VmHWM for its peak; 0 if not available
+G4double GetMemory(const std::string &key) {
+#ifdef __linux__
+  std::ifstream status("/proc/self/status");
+  std::string name;
+  while (status >> name) {
+    if (name == key + ":") {
+      G4double kB = 0.;
+      status >> kB;
+      return kB / 1024.;
+    }
+    status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+#endif
+  return 0.;
+}
+
+// Reset the peak resident set size (VmHWM) of the process
+void ResetPeakMemory() {
+#ifdef __linux__
+  std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+// Names of the detectors in the order of the event records
+std::vector<G4String> GetDetectorNames() {
+  auto detector = static_cast<const B4d::DetectorConstruction *>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  std::vector<G4String> detectorNames;
+  for (G4int i = 0; i < detector->GetNofRingDetectors(); ++i) {
+    detectorNames.push_back(B4d::RingSD::GetDetectorName(i));
+  }
+  detectorNames.push_back("TargetDet");
+  detectorNames.push_back("NDet");
+  return detectorNames;
+}
+
+// Name of an output file which follows the analysis output file, eg.
+// B4.root -> B4_spectra.csv
+G4String GetOutputFileName(const G4String &suffix) {
+  std::string fileName = G4AnalysisManager::Instance()->GetFileName();
+  auto extension = fileName.rfind('.');
+  if (extension != std::string::npos &&
+      (fileName.rfind('/') == std::string::npos ||
+       extension > fileName.rfind('/'))) {
+    fileName.erase(extension);
+  }
+  return fileName + suffix;
+}
+
+// Ring layout, shell and ring scorer of the current geometry, as a one
+// line key of the results which depend on them
+G4String GetRingSetup() {
+  auto detector = static_cast<const B4d::DetectorConstruction *>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  std::ostringstream setup;
+  setup << "ring " << detector->GetRingRadius() / mm << " mm, angles";
+  for (auto angle : detector->GetRingAngles()) setup << ' ' << angle / deg;
+  setup << " deg, detectors " << detector->GetDetectorDiameter() / mm << " x "
+        << detector->GetDetectorHeight() / mm << " mm, shell "
+        << detector->GetShell() << ", scorer " << detector->GetRingScorer();
+  return setup.str();
+}
+
+// Primaries of the events and ring setup, as a one line key
+G4String GetFullSimulationSetup(
+    const B4::GunParameters &gun,
+    const B4d::PhaseSpaceParameters &phaseSpace) {
+  std::ostringstream setup;
+  if (!phaseSpace.inputFile.empty()) {
+    setup << "phase space " << phaseSpace.inputFile << ' '
+          << phaseSpace.mode << ' ' << phaseSpace.neutronsPerEvent;
+  } else if (gun.species != "bunch") {
+    setup << gun.species << ' ' << gun.momentum / GeV << " GeV";
+  } else {
+    setup << "bunch " << gun.nofPositrons << " e+ " << gun.nofPions
+          << " pi+ " << gun.nofProtons << " p " << gun.nofNeutrons << " n "
+          << gun.momentum / GeV << " GeV in " << gun.chunksPerBunch
+          << " event(s)";
+  }
+  setup << ", " << GetRingSetup();
+  return setup.str();
+}
+
+// Ring counts per event and CPU time per event of a run with the full
+// simulation, in a process without the fast simulation physics, with the
+// setup of the run; they are the reference of the fast shower validation
+// in the processes with it
+void WriteFullSimulation(const G4String &fileName, const G4String &setup,
+                         const std::vector<G4double> &means,
+                         const std::vector<G4double> &errors,
+                         G4double timePerEvent) {
+  std::ofstream file(fileName);
+  file.precision(std::numeric_limits<G4double>::max_digits10);
+  file << "setup " << setup << '\n';
+  file << "time " << timePerEvent << '\n';
+  for (std::size_t i = 0; i < means.size(); ++i) {
+    file << B4d::RingSD::GetDetectorName(G4int(i)) << ' ' << means[i] << ' '
+         << errors[i] << '\n';
+  }
+}
+
+G4bool ReadFullSimulation(const G4String &fileName, G4String &setup,
+                          std::vector<G4double> &means,
+                          std::vector<G4double> &errors,
+                          G4double &timePerEvent) {
+  std::ifstream file(fileName);
+  std::string name;
+  if (!(file >> name) || name != "setup") return false;
+  std::getline(file >> std::ws, setup);
+  if (!(file >> name >> timePerEvent) || name != "time") return false;
+  means.clear();
+  errors.clear();
+  G4double mean = 0.;
+  G4double error = 0.;
+  while (file >> name >> mean >> error) {
+    means.push_back(mean);
+    errors.push_back(error);
+  }
+  return !means.empty();
+}
+
+} // namespace
+
 namespace B4 {
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-RunAction::RunAction() {
+RunAction::RunAction(
+    const GunParameters *gunParameters,
+    const B4d::PhaseSpaceParameters *phaseSpaceParameters,
+    const B4d::ConvergenceParameters *convergenceParameters,
+    B4d::EventAction *eventAction)
+    : fGunParameters(gunParameters),
+      fPhaseSpaceParameters(phaseSpaceParameters),
+      fConvergenceParameters(convergenceParameters) {
   // set printing event number per each event
   G4RunManager::GetRunManager()->SetPrintProgress(1);
 
@@ -55,8 +208,45 @@ RunAction::RunAction() {
   analysisManager->SetNtupleMerging(true);
   // Note: merging ntuples is available only with Root output
 
+  // Default output file
+  G4String fileName = "B4.root";
+  // Other supported output types:
+  // G4String fileName = "B4.csv";
+  // G4String fileName = "B4.hdf5";
+  // G4String fileName = "B4.xml";
+  analysisManager->SetFileName(fileName);
+
   // Book histograms, ntuple
   //
+  analysisManager->CreateH1("TCount", "Track Counter in Gaps", 110, 0., 1000.);
+
+  // the Detectors column is the event record of the EventAction:
+  // Gap ... GapN, TargetDet, NDet (the master has no EventAction, its
+  // column is only used to merge the ntuples of the workers)
+  auto &record = eventAction ? eventAction->GetRecord() : fRecord;
+  analysisManager->CreateNtuple("B4", "TrackCount");
+  analysisManager->CreateNtupleDColumn("TCount");
+  analysisManager->CreateNtupleDColumn("Detectors", record);
+  analysisManager->FinishNtuple();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4Run *RunAction::GenerateRun() {
+  // the Lambertian approximation follows the current ring layout
+  auto detector = static_cast<const B4d::DetectorConstruction *>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  B4d::LambertianApproximation approximation;
+  approximation.SetRing(detector->GetRingRadius(),
+                        detector->GetRingAngles(),
+                        detector->GetDetectorDiameter(),
+                        detector->GetDetectorHeight());
+
+  auto run = new B4d::Run;
+  run->SetLambertianApproximation(approximation);
+  run->BookOriginCounts(detector->GetNofRingDetectors());
+  run->BookSpectra(detector->GetNofRingDetectors());
+  return run;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -68,20 +258,123 @@ void RunAction::BeginOfRunAction(const G4Run * /*run*/) {
   // Get analysis manager
   auto analysisManager = G4AnalysisManager::Instance();
 
-  // Open an output file
+  // Open an output file, named in the constructor or with
+  // /analysis/setFileName
   //
-  G4String fileName = "B4.root";
-  // Other supported output types:
-  // G4String fileName = "B4.csv";
-  // G4String fileName = "B4.hdf5";
-  // G4String fileName = "B4.xml";
-  analysisManager->OpenFile(fileName);
+  analysisManager->OpenFile();
   G4cout << "Using " << analysisManager->GetType() << G4endl;
+
+  if (isMaster) {
+    B4d::BunchMerger::Instance()->Clear();
+    if (!fPhaseSpaceParameters->outputFile.empty()) {
+      B4d::PhaseSpaceWriter::Instance()->Open(
+          fPhaseSpaceParameters->outputFile);
+    }
+    // loaded once per run, before the workers generate their primaries
+    if (!fPhaseSpaceParameters->inputFile.empty()) {
+      B4d::PhaseSpaceReader::Instance()->Load(
+          fPhaseSpaceParameters->inputFile);
+    }
+
+    B4d::ConvergenceMonitor::Instance()->Start(*fConvergenceParameters,
+                                               GetDetectorNames());
+
+    B4d::WorkerTimeline::Instance()->Start(
+        G4RunManager::GetRunManager()->GetNumberOfThreads());
+
+    ResetPeakMemory();
+    fMemoryAtBegin = GetMemory("VmRSS");
+    fTimer.Start();
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::EndOfRunAction(const G4Run * /*run*/) {
+void RunAction::EndOfRunAction(const G4Run *run) {
+  // the master closes the phase space file after the workers flushed it
+  if (isMaster) {
+    B4d::PhaseSpaceWriter::Instance()->Close();
+  } else {
+    B4d::PhaseSpaceWriter::Instance()->Flush();
+  }
+
+  auto nofEvents = run->GetNumberOfEvent();
+  if (isMaster && nofEvents > 0) {
+    fTimer.Stop();
+    auto b4Run = static_cast<const B4d::Run *>(run);
+    auto cpuTime = fTimer.GetUserElapsed() + fTimer.GetSystemElapsed();
+    auto timePerEvent = cpuTime / nofEvents;
+
+    G4cout << G4endl
+           << "--------------------End of Global Run-----------------------"
+           << G4endl << " The run consists of " << nofEvents << " events."
+           << G4endl;
+    b4Run->PrintRingCounts();
+    b4Run->PrintOriginCounts();
+    auto nofIncomplete =
+        B4d::BunchMerger::Instance()->GetNofIncompleteBunches();
+    if (nofIncomplete > 0) {
+      G4cout << " WARNING: " << nofIncomplete
+             << " incomplete bunch(es) not written, the number of events"
+             << " must be a multiple of /B4/gun/chunksPerBunch" << G4endl;
+    }
+    b4Run->PrintStackingStatistics();
+    b4Run->PrintKillZoneStatistics();
+    b4Run->PrintStackDepth();
+    b4Run->PrintFastShowerStatistics();
+    b4Run->PrintBiasingStatistics();
+    ValidateFastShowers(b4Run, timePerEvent);
+    b4Run->WriteSpectra(GetOutputFileName("_spectra.csv"));
+    b4Run->PrintStepProfile();
+    b4Run->WriteStepProfile(GetOutputFileName("_profile.csv"));
+    if (fGunParameters->species != "bunch") {
+      B4d::ResponseLibrary::Instance()->Add(
+          fGunParameters->species, fGunParameters->momentum, GetRingSetup(),
+          GetDetectorNames(), b4Run->GetNofResponses(),
+          b4Run->GetResponseSums(), b4Run->GetResponseProducts());
+    }
+    auto nofThreads =
+        std::max(1, G4Threading::GetNumberOfRunningWorkerThreads());
+    // the RSS is the one of the whole process, the threads share it
+    auto peakMemory = GetMemory("VmHWM");
+    if (peakMemory > 0.) {
+      G4cout << " Memory (RSS): " << fMemoryAtBegin
+             << " MB at the beginning of run, peak " << peakMemory
+             << " MB, growth " << peakMemory - fMemoryAtBegin << " MB with "
+             << nofThreads << " thread(s)" << G4endl;
+    }
+    B4d::ConvergenceMonitor::Instance()->Print();
+    G4cout << " CPU time: " << cpuTime << " s (" << timePerEvent
+           << " s/event), real time: " << fTimer.GetRealElapsed() << " s"
+           << G4endl;
+    PrintFigureOfMerit(b4Run, cpuTime);
+    // steps/s, to compare the geometry and scoring options
+    auto nofSteps = b4Run->GetNofSteps();
+    auto realTime = fTimer.GetRealElapsed();
+    G4cout << " Steps: " << nofSteps << " ("
+           << (cpuTime > 0. ? nofSteps / cpuTime : 0.) << " /s CPU, "
+           << (realTime > 0. ? nofSteps / realTime : 0.) << " /s real)"
+           << G4endl;
+    // events/s, for the scaling with the number of threads (scaling.sh)
+    G4cout << " Event rate: " << (realTime > 0. ? nofEvents / realTime : 0.)
+           << " events/s real with " << nofThreads << " thread(s)" << G4endl;
+    B4d::WorkerTimeline::Instance()->Write(
+        GetOutputFileName("_timeline.csv"));
+
+    auto nofKilled =
+        b4Run->GetNofKilledTracks() + b4Run->GetNofZoneKilledTracks();
+    if (nofKilled == 0) {
+      fReferenceTimePerEvent = timePerEvent;
+    } else if (fReferenceTimePerEvent > 0.) {
+      G4cout << " CPU saved by track killing: "
+             << (fReferenceTimePerEvent - timePerEvent) * nofEvents << " s ("
+             << 100. * (1. - timePerEvent / fReferenceTimePerEvent)
+             << " % of the last run without killing)" << G4endl;
+    }
+    G4cout << "------------------------------------------------------------"
+           << G4endl;
+  }
+
   // print histogram statistics
   //
   auto analysisManager = G4AnalysisManager::Instance();
@@ -102,4 +395,139 @@ void RunAction::EndOfRunAction(const G4Run * /*run*/) {
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void RunAction::ValidateFastShowers(const B4d::Run *run,
+                                    G4double timePerEvent) {
+  auto detector = static_cast<const B4d::DetectorConstruction *>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  const auto &parameters = detector->GetFastShowerParameters();
+  auto nofEvents = run->GetNumberOfEvent();
+  const auto &counts = run->GetRingCounts();
+  const auto &counts2 = run->GetRingCounts2();
+
+  // ring counts per event and their errors
+  std::vector<G4double> means(counts.size());
+  std::vector<G4double> errors(counts.size());
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    means[i] = counts[i] / nofEvents;
+    errors[i] =
+        means[i] * B4d::Run::GetRelativeError(counts[i], counts2[i], nofEvents);
+  }
+
+  // the process of the fast simulation physics is applied to the e+, e-
+  // and gamma steps of the full simulation too: the reference is read from
+  // the file of a process without it, if any, else it is the last run with
+  // the full simulation; a reference of another setup is refused
+  auto setup = GetFullSimulationSetup(*fGunParameters, *fPhaseSpaceParameters);
+  auto fileName = GetOutputFileName("_fullSimulation.txt");
+  if (!parameters.enabled) {
+    fFullSetup = setup;
+    fFullRingMeans = means;
+    fFullRingErrors = errors;
+    fFullTimePerEvent = timePerEvent;
+    if (parameters.validate && !detector->GetFastSimulation()) {
+      WriteFullSimulation(fileName, setup, means, errors, timePerEvent);
+    }
+    return;
+  }
+  if (!parameters.validate) return;
+
+  auto isValid = [&](const G4String &source, const G4String &fullSetup,
+                     const std::vector<G4double> &fullMeans) {
+    if (fullSetup != setup) {
+      G4cout << " Fast shower validation: " << source
+             << " refused, its setup differs:" << G4endl << "   "
+             << fullSetup << G4endl << " instead of" << G4endl << "   "
+             << setup << G4endl;
+      return false;
+    }
+    if (fullMeans.size() != means.size()) {
+      G4cout << " Fast shower validation: " << source << " refused, "
+             << fullMeans.size() << " ring detectors instead of "
+             << means.size() << G4endl;
+      return false;
+    }
+    return true;
+  };
+
+  G4String fullSetup;
+  std::vector<G4double> fullMeans;
+  std::vector<G4double> fullErrors;
+  G4double fullTimePerEvent = 0.;
+  G4String reference;
+  if (ReadFullSimulation(fileName, fullSetup, fullMeans, fullErrors,
+                         fullTimePerEvent) &&
+      isValid(fileName, fullSetup, fullMeans)) {
+    reference = "file " + fileName +
+                " (process without the fast simulation physics)";
+  } else if (!fFullRingMeans.empty() &&
+             isValid("last run with the full simulation", fFullSetup,
+                     fFullRingMeans)) {
+    fullMeans = fFullRingMeans;
+    fullErrors = fFullRingErrors;
+    fullTimePerEvent = fFullTimePerEvent;
+    reference = "last run with the full simulation of this process";
+  }
+  if (reference.empty()) {
+    G4cout << " Fast shower validation: no run with the full simulation"
+           << " and the same setup" << G4endl;
+    return;
+  }
+
+  G4cout << " Fast shower validation against the " << reference << ","
+         << G4endl << " setup: " << setup << "," << G4endl
+         << " ring counts per event:" << G4endl
+         << "   " << std::setw(6) << "" << "  " << std::setw(12) << "full"
+         << std::setw(10) << "error" << std::setw(12) << "fast"
+         << std::setw(10) << "error" << std::setw(10) << "ratio"
+         << std::setw(12) << "deviation" << G4endl;
+  for (std::size_t i = 0; i < means.size(); ++i) {
+    auto error =
+        std::sqrt(errors[i] * errors[i] + fullErrors[i] * fullErrors[i]);
+    G4cout << "   " << std::setw(6) << B4d::RingSD::GetDetectorName(G4int(i))
+           << ": " << std::setw(12) << fullMeans[i] << std::setw(10)
+           << fullErrors[i] << std::setw(12) << means[i] << std::setw(10)
+           << errors[i] << std::setw(10)
+           << (fullMeans[i] > 0. ? means[i] / fullMeans[i] : 0.)
+           << std::setw(10)
+           << (error > 0. ? (means[i] - fullMeans[i]) / error : 0.)
+           << " sigma" << G4endl;
+  }
+  if (timePerEvent > 0.) {
+    G4cout << "   CPU time per event: " << fullTimePerEvent / timePerEvent
+           << " times faster than the full simulation" << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::PrintFigureOfMerit(const B4d::Run *run, G4double cpuTime) {
+  if (cpuTime <= 0.) return;
+
+  auto nofEvents = run->GetNumberOfEvent();
+  const auto &counts = run->GetRingCounts();
+  const auto &counts2 = run->GetRingCounts2();
+  std::vector<G4double> figureOfMerit(counts.size());
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    auto error = B4d::Run::GetRelativeError(counts[i], counts2[i], nofEvents);
+    figureOfMerit[i] = (error > 0.) ? 1. / (error * error * cpuTime) : 0.;
+  }
+
+  auto isBiased = run->IsBiased() && !fAnalogFigureOfMerit.empty();
+  G4cout << " Figure of merit 1/(error^2 T) of the ring counts (1/s):"
+         << G4endl;
+  for (std::size_t i = 0; i < figureOfMerit.size(); ++i) {
+    G4cout << "   " << std::setw(6) << B4d::RingSD::GetDetectorName(G4int(i))
+           << ": " << std::setw(12) << figureOfMerit[i];
+    if (isBiased && i < fAnalogFigureOfMerit.size() &&
+        fAnalogFigureOfMerit[i] > 0.) {
+      G4cout << std::setw(10) << figureOfMerit[i] / fAnalogFigureOfMerit[i]
+             << " times the analog run";
+    }
+    G4cout << G4endl;
+  }
+  if (!run->IsBiased()) fAnalogFigureOfMerit = figureOfMerit;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 } // namespace B4
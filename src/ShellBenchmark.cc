@@ -0,0 +1,200 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/ShellBenchmark.cc
+/// \brief Implementation of the B4d::ShellBenchmark class
+
+#include "ShellBenchmark.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4Box.hh"
+#include "G4GeometryManager.hh"
+#include "G4Navigator.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Timer.hh"
+#include "G4TransportationManager.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include <cmath>
+#include <iomanip>
+#include <random>
+
+namespace {
+
+// maximum number of navigation steps per ray
+const G4int kMaxSteps = 1000;
+
+} // namespace
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ShellBenchmark::ShellBenchmark(G4double outerHalfLength,
+                               G4double innerHalfLength)
+    : fOuterHalfLength(outerHalfLength) {
+  auto outer = new G4Box("BenchOuterBox", outerHalfLength, outerHalfLength,
+                         outerHalfLength);
+  auto inner = new G4Box("BenchInnerBox", innerHalfLength, innerHalfLength,
+                         innerHalfLength);
+
+  // the boolean solid does not own its constituents: they are kept in the
+  // nested shell, which is deleted after it
+  Shell subtraction{"subtraction", {}, {}};
+  subtraction.solids.push_back(
+      new G4SubtractionSolid("BenchHollowBox", outer, inner));
+  subtraction.positions.emplace_back();
+  fShells.push_back(subtraction);
+
+  fShells.push_back({"nested", {outer, inner}, {{}, {}}});
+
+  Shell slabs{"slabs", {}, {}};
+  for (const auto &slab :
+       DetectorConstruction::GetShellSlabs(outerHalfLength, innerHalfLength)) {
+    slabs.solids.push_back(new G4Box("BenchSlab", slab.halfLengths.x(),
+                                     slab.halfLengths.y(),
+                                     slab.halfLengths.z()));
+    slabs.positions.push_back(slab.position);
+  }
+  fShells.push_back(slabs);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ShellBenchmark::~ShellBenchmark() {
+  for (const auto &shell : fShells) {
+    for (auto solid : shell.solids) delete solid;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ShellBenchmark::Run(G4int nofPoints) const {
+  // points uniform in a box slightly larger than the shell, isotropic
+  // directions
+  std::mt19937_64 engine(12345);
+  std::uniform_real_distribution<G4double> flat(-1., 1.);
+  std::vector<G4ThreeVector> points(nofPoints);
+  std::vector<G4ThreeVector> directions(nofPoints);
+  auto halfLength = 1.1 * fOuterHalfLength;
+  for (G4int i = 0; i < nofPoints; ++i) {
+    points[i].set(halfLength * flat(engine), halfLength * flat(engine),
+                  halfLength * flat(engine));
+    auto cosTheta = flat(engine);
+    auto sinTheta = std::sqrt(1. - cosTheta * cosTheta);
+    auto phi = pi * flat(engine);
+    directions[i].set(sinTheta * std::cos(phi), sinTheta * std::sin(phi),
+                      cosTheta);
+  }
+
+  G4cout << G4endl << " NDet shell benchmark, " << nofPoints
+         << " random points:" << G4endl;
+  for (const auto &shell : fShells) TimeSolids(shell, points, directions);
+  TimeNavigation(points, directions);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ShellBenchmark::TimeSolids(
+    const Shell &shell, const std::vector<G4ThreeVector> &points,
+    const std::vector<G4ThreeVector> &directions) const {
+  // the sum of the distances keeps the calls from being optimized away
+  G4long nofCalls = 0;
+  G4double sum = 0.;
+  G4Timer timer;
+  timer.Start();
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    for (std::size_t j = 0; j < shell.solids.size(); ++j) {
+      auto solid = shell.solids[j];
+      auto point = points[i] - shell.positions[j];
+      if (solid->Inside(point) == kOutside) {
+        sum += std::min(solid->DistanceToIn(point, directions[i]), 10. * m);
+      } else {
+        sum += solid->DistanceToOut(point, directions[i]);
+      }
+      nofCalls += 2;
+    }
+  }
+  timer.Stop();
+
+  auto time = timer.GetUserElapsed() + timer.GetSystemElapsed();
+  G4cout << "   " << std::setw(12) << shell.name << ": " << std::setw(12)
+         << (time > 0. ? nofCalls / time : 0.) << " solid calls/s, "
+         << std::setw(12) << (time > 0. ? points.size() / time : 0.)
+         << " points/s (distance sum " << sum / m << " m)" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ShellBenchmark::TimeNavigation(
+    const std::vector<G4ThreeVector> &points,
+    const std::vector<G4ThreeVector> &directions) const {
+  auto world = G4TransportationManager::GetTransportationManager()
+                   ->GetNavigatorForTracking()
+                   ->GetWorldVolume();
+  if (!world) {
+    G4Exception("ShellBenchmark::TimeNavigation()", "MyCode0009", JustWarning,
+                "No geometry: run /run/initialize first.");
+    return;
+  }
+
+  // optimise the geometry as for a run, if not yet done
+  G4GeometryManager::GetInstance()->CloseGeometry(true);
+
+  G4Navigator navigator;
+  navigator.SetWorldVolume(world);
+  G4long nofSteps = 0;
+  G4Timer timer;
+  timer.Start();
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    auto point = points[i];
+    auto direction = directions[i];
+    auto volume =
+        navigator.LocateGlobalPointAndSetup(point, &direction, false, false);
+    for (G4int j = 0; volume && j < kMaxSteps; ++j) {
+      G4double safety = 0.;
+      auto step = navigator.ComputeStep(point, direction, kInfinity, safety);
+      ++nofSteps;
+      if (step == kInfinity) break;
+      point += step * direction;
+      navigator.SetGeometricallyLimitedStep();
+      volume = navigator.LocateGlobalPointAndSetup(point, &direction, true);
+    }
+  }
+  timer.Stop();
+
+  auto time = timer.GetUserElapsed() + timer.GetSystemElapsed();
+  G4cout << "   " << std::setw(12) << "navigation" << ": " << std::setw(12)
+         << (time > 0. ? nofSteps / time : 0.) << " steps/s, "
+         << std::setw(12) << (time > 0. ? points.size() / time : 0.)
+         << " rays/s in the current geometry" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,75 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/ShellCrossingFilter.cc
+/// \brief Implementation of the B4d::ShellCrossingFilter class
+
+#include "ShellCrossingFilter.hh"
+
+#include "G4Step.hh"
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ShellCrossingFilter::ShellCrossingFilter(const G4String &name, Mode mode)
+    : G4VSDFilter(name), fMode(mode) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ShellCrossingFilter::Accept(const G4Step *step) const {
+  auto track = step->GetTrack();
+  auto preStepPoint = step->GetPreStepPoint();
+  auto postStepPoint = step->GetPostStepPoint();
+  G4bool preBoundary = preStepPoint->GetStepStatus() == fGeomBoundary;
+  G4bool postBoundary = postStepPoint->GetStepStatus() == fGeomBoundary;
+
+  // the step continues the previous one across an internal boundary
+  G4bool continued = preBoundary && track->GetTrackID() == fTrackID &&
+                     track->GetCurrentStepNumber() == fStepNumber + 1;
+  G4bool entered = continued ? fEntered : preBoundary;
+
+  // the step ends in another volume of the same detector
+  G4bool internal =
+      postBoundary && postStepPoint->GetSensitiveDetector() &&
+      postStepPoint->GetSensitiveDetector() ==
+          preStepPoint->GetSensitiveDetector();
+
+  if (internal) {
+    fTrackID = track->GetTrackID();
+    fStepNumber = track->GetCurrentStepNumber();
+    fEntered = entered;
+  } else {
+    fTrackID = -1;
+  }
+
+  if (fMode == kEntry) return preBoundary && !continued;
+  return !internal && (entered || postBoundary);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,120 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/Spectra.cc
+/// \brief Implementation of the B4d::Spectra class
+
+#include "Spectra.hh"
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Spectra::Book(G4int nofDetectors) {
+  fNofDetectors = nofDetectors;
+  fEnergy.assign(nofDetectors * kNofEnergyCells, 0.);
+  fTime.assign(nofDetectors * kNofTimeCells, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Spectra::Merge(const Spectra &other) {
+  if (fNofDetectors < other.fNofDetectors) Book(other.fNofDetectors);
+  for (std::size_t i = 0; i < other.fEnergy.size(); ++i) {
+    fEnergy[i] += other.fEnergy[i];
+  }
+  for (std::size_t i = 0; i < other.fTime.size(); ++i) {
+    fTime[i] += other.fTime[i];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Spectra::Write(const G4String &fileName,
+                    const std::vector<G4String> &detectorNames) const {
+  std::ofstream file(fileName);
+  if (!file) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open spectra file " << fileName;
+    G4Exception("Spectra::Write()", "MyCode0008", JustWarning, msg);
+    return;
+  }
+
+  // the values are written in full precision, to be compared exactly
+  // between runs (see equivalence.sh)
+  file.precision(std::numeric_limits<G4double>::max_digits10);
+
+  // the first and last bins of each spectrum are the underflow and the
+  // overflow, with an open edge
+  file << "# neutrons entering the detectors: kinetic energy (MeV) and time"
+       << " of flight (ns) spectra\n"
+       << "detector,spectrum,low,high,value\n";
+  auto energyEdge = [](G4int i) {
+    return kEnergyMin / MeV * std::pow(10., G4double(i) / kEnergyBinsPerDecade);
+  };
+  for (G4int detector = 0; detector < fNofDetectors; ++detector) {
+    const auto &name = detectorNames[detector];
+    for (G4int cell = 0; cell < kNofEnergyCells; ++cell) {
+      file << name << ",energy,";
+      if (cell == 0) {
+        file << 0.;
+      } else {
+        file << energyEdge(cell - 1);
+      }
+      file << ",";
+      if (cell == kNofEnergyCells - 1) {
+        file << "inf";
+      } else {
+        file << energyEdge(cell);
+      }
+      file << "," << fEnergy[detector * kNofEnergyCells + cell] << "\n";
+    }
+    for (G4int cell = 0; cell < kNofTimeCells; ++cell) {
+      file << name << ",time,";
+      if (cell == 0) {
+        file << "-inf";
+      } else {
+        file << (cell - 1) * kTimeBinWidth / ns;
+      }
+      file << ",";
+      if (cell == kNofTimeCells - 1) {
+        file << "inf";
+      } else {
+        file << cell * kTimeBinWidth / ns;
+      }
+      file << "," << fTime[detector * kNofTimeCells + cell] << "\n";
+    }
+  }
+  G4cout << " Neutron spectra written in " << fileName << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,65 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/SpectrumScorer.cc
+/// \brief Implementation of the B4d::SpectrumScorer class
+
+#include "SpectrumScorer.hh"
+#include "Run.hh"
+
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpectrumScorer::SpectrumScorer(const G4String &name, G4int spectrum)
+    : G4VPrimitiveScorer(name), fSpectrum(spectrum) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpectrumScorer::Initialize(G4HCofThisEvent * /*hce*/) {
+  fRun = static_cast<Run *>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SpectrumScorer::ProcessHits(G4Step *step,
+                                   G4TouchableHistory * /*history*/) {
+  auto preStepPoint = step->GetPreStepPoint();
+  if (preStepPoint->GetStepStatus() != fGeomBoundary) return false;
+
+  fRun->FillSpectra(fSpectrum, preStepPoint->GetKineticEnergy(),
+                    preStepPoint->GetGlobalTime(),
+                    preStepPoint->GetWeight());
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,102 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/StackingAction.cc
+/// \brief Implementation of the B4d::StackingAction class
+
+#include "StackingAction.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "Run.hh"
+
+#include "G4EventManager.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4RunManager.hh"
+#include "G4StackManager.hh"
+#include "G4Track.hh"
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingAction::StackingAction(const StackingParameters *parameters,
+                               B4::PrimaryGeneratorAction *primaryGenerator)
+    : fParameters(parameters), fPrimaryGenerator(primaryGenerator) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::PrepareNewEvent() {
+  // the run and the geometry may change between events of different runs
+  fRun = static_cast<Run *>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  fTargetLV = G4LogicalVolumeStore::GetInstance()->GetVolume("Target", false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::NewStage() {
+  if (fParameters->primariesPerStage <= 0) return;
+
+  // the urgent stack is empty: release the next batch of primaries; the
+  // event manager numbers them and stacks them via ClassifyNewTrack()
+  auto eventManager = G4EventManager::GetEventManager();
+  G4TrackVector tracks;
+  fPrimaryGenerator->ReleasePrimaries(eventManager->GetNonconstCurrentEvent(),
+                                      tracks);
+  if (!tracks.empty()) eventManager->StackTracks(&tracks);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack
+StackingAction::ClassifyNewTrack(const G4Track *track) {
+  fRun->SetStackDepth(stackManager->GetNTotalTrack(),
+                      stackManager->GetNUrgentTrack());
+
+  // keep primaries
+  if (track->GetParentID() == 0) return fUrgent;
+
+  auto species = Run::GetSpecies(track->GetDefinition());
+  auto kinEnergy = track->GetKineticEnergy();
+
+  G4bool kill = false;
+  if (species == Run::kGamma || species == Run::kElectron ||
+      species == Run::kPositron) {
+    kill = kinEnergy < fParameters->emKillThreshold;
+  }
+  if (!kill && fParameters->killOutsideTarget && species != Run::kNeutron) {
+    // secondaries inherit the touchable of their parent step
+    auto volume = track->GetVolume();
+    kill = volume && volume->GetLogicalVolume() != fTargetLV;
+  }
+  if (!kill) return fUrgent;
+
+  fRun->AddKilledTrack(species, kinEnergy);
+  return fKill;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,150 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/StartupProfiler.cc
+/// \brief Implementation of the B4d::StartupProfiler class
+
+#include "StartupProfiler.hh"
+
+#include "G4AutoLock.hh"
+#include "G4StateManager.hh"
+
+#include <iomanip>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StartupProfiler *StartupProfiler::fInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StartupProfiler::StartupProfiler()
+    : fStartTime(std::chrono::steady_clock::now()), fStartClock(std::clock()) {
+  fInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StartupProfiler::~StartupProfiler() {
+  // no event was processed
+  if (!fIsDone && !fPhases.empty()) Print();
+  fInstance = nullptr;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StartupProfiler::Notify(G4ApplicationState requestedState) {
+  if (fIsDone) return true;
+
+  // the current state is still the previous one
+  auto state = G4StateManager::GetStateManager()->GetCurrentState();
+  G4AutoLock lock(&fMutex);
+  if (state == G4State_PreInit && requestedState == G4State_Init) {
+    EndPhase("job setup");
+  } else if (state == G4State_Init && requestedState == G4State_Idle &&
+             !fIsPhysicsConstructed) {
+    EndPhase("parallel worlds and physics construction");
+    fIsPhysicsConstructed = true;
+  } else if (state == G4State_Idle && requestedState == G4State_Init &&
+             fIsPhysicsConstructed) {
+    EndPhase("UI commands");
+  } else if (state == G4State_Idle && requestedState == G4State_GeomClosed) {
+    EndPhase(fIsTableBuilt ? "run initialization" : "physics tables");
+    fIsTableBuilt = true;
+  } else if (state == G4State_GeomClosed && requestedState == G4State_Idle) {
+    EndPhase("worker threads start");
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StartupProfiler::EndPhase(const G4String &name) {
+  auto now = std::chrono::steady_clock::now();
+  auto clock = std::clock();
+  std::chrono::duration<G4double> realTime = now - fStartTime;
+
+  Phase phase;
+  phase.name = name;
+  phase.realTime = realTime.count();
+  phase.cpuTime = G4double(clock - fStartClock) / CLOCKS_PER_SEC;
+  fPhases.push_back(phase);
+
+  fStartTime = now;
+  fStartClock = clock;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StartupProfiler::Mark(const G4String &name) {
+  if (!G4Threading::IsMasterThread()) return;
+
+  G4AutoLock lock(&fMutex);
+  if (!fIsPhysicsConstructed) EndPhase(name);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StartupProfiler::EndOfEvent() {
+  if (fIsDone) return;
+
+  G4AutoLock lock(&fMutex);
+  if (fIsDone) return;
+  EndPhase("first event");
+  Print();
+  fIsDone = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StartupProfiler::Print() const {
+  G4double totalRealTime = 0.;
+  G4double totalCpuTime = 0.;
+
+  G4cout << G4endl
+         << "--------------------Startup time (s)--------------------" << G4endl
+         << std::setw(40) << std::left << " Phase" << std::right
+         << std::setw(8) << "real" << std::setw(8) << "CPU" << G4endl;
+  for (const auto &phase : fPhases) {
+    G4cout << " " << std::setw(39) << std::left << phase.name << std::right
+           << std::fixed << std::setprecision(3) << std::setw(8)
+           << phase.realTime << std::setw(8) << phase.cpuTime << G4endl;
+    totalRealTime += phase.realTime;
+    totalCpuTime += phase.cpuTime;
+  }
+  G4cout << " " << std::setw(39) << std::left << "total" << std::right
+         << std::setw(8) << totalRealTime << std::setw(8) << totalCpuTime
+         << std::defaultfloat << std::setprecision(6) << G4endl
+         << " (the CPU time is summed over all the threads)" << G4endl
+         << "--------------------------------------------------------"
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
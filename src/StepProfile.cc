@@ -0,0 +1,172 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/StepProfile.cc
+/// \brief Implementation of the B4d::StepProfile class
+
+#include "StepProfile.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfile::AddStep(const G4Step *step) {
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<G4double> time = now - fLastTime;
+  fLastTime = now;
+
+  auto track = step->GetTrack();
+  Key key;
+  key.particle = track->GetDefinition();
+  key.volume = step->GetPreStepPoint()->GetPhysicalVolume()->GetLogicalVolume();
+  key.creator = track->GetCreatorProcess();
+
+  auto &entry = fEntries[key];
+  if (track->GetCurrentStepNumber() == 1) ++entry.nofTracks;
+  ++entry.nofSteps;
+  entry.time += time.count();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfile::Add(Entry &entry, const Entry &other) {
+  entry.nofTracks += other.nofTracks;
+  entry.nofSteps += other.nofSteps;
+  entry.time += other.time;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepProfile::NamedEntries StepProfile::GetNamedEntries() const {
+  auto namedEntries = fNamedEntries;
+  for (const auto &[key, entry] : fEntries) {
+    Names names = {key.particle->GetParticleName(), key.volume->GetName(),
+                   key.creator ? key.creator->GetProcessName()
+                               : G4String("primary")};
+    Add(namedEntries[names], entry);
+  }
+  return namedEntries;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfile::Merge(const StepProfile &other) {
+  for (const auto &[names, entry] : other.GetNamedEntries()) {
+    Add(fNamedEntries[names], entry);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfile::Print(G4int nofRows) const {
+  auto namedEntries = GetNamedEntries();
+  if (namedEntries.empty()) return;
+
+  Entry total;
+  std::array<std::map<G4String, Entry>, 3> totals; // per name
+  std::vector<std::pair<Names, Entry>> entries;
+  for (const auto &[names, entry] : namedEntries) {
+    Add(total, entry);
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      Add(totals[i][names[i]], entry);
+    }
+    entries.emplace_back(names, entry);
+  }
+  std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+    return a.second.time > b.second.time;
+  });
+
+  auto printRow = [&](const G4String &name, const Entry &entry) {
+    auto share = (total.time > 0.) ? 100. * entry.time / total.time : 0.;
+    G4cout << "   " << std::setw(48) << std::left << name << std::right
+           << std::setw(12) << entry.nofTracks << std::setw(14)
+           << entry.nofSteps << std::setw(10) << std::setprecision(4)
+           << entry.time << std::setw(8) << std::setprecision(3) << share
+           << " %" << std::setw(10)
+           << 1.e6 * entry.time / std::max(entry.nofSteps, G4long(1))
+           << G4endl;
+  };
+  auto printHeader = [](const G4String &title) {
+    G4cout << "   " << std::setw(48) << std::left << title << std::right
+           << std::setw(12) << "tracks" << std::setw(14) << "steps"
+           << std::setw(10) << "time (s)" << std::setw(10) << "share"
+           << std::setw(10) << "us/step" << G4endl;
+  };
+
+  G4cout << G4endl << " Step profile: " << total.nofSteps << " steps in "
+         << total.time << " s (thread time, summed over the threads)"
+         << G4endl;
+  printHeader("particle / volume / creator process");
+  for (std::size_t i = 0;
+       i < std::min(entries.size(), std::size_t(std::max(nofRows, 0)));
+       ++i) {
+    const auto &names = entries[i].first;
+    printRow(names[0] + " / " + names[1] + " / " + names[2],
+             entries[i].second);
+  }
+
+  const char *titles[] = {"particle", "volume", "creator process"};
+  for (std::size_t i = 0; i < totals.size(); ++i) {
+    std::vector<std::pair<G4String, Entry>> sorted(totals[i].begin(),
+                                                   totals[i].end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+      return a.second.time > b.second.time;
+    });
+    G4cout << G4endl;
+    printHeader(titles[i]);
+    for (const auto &[name, entry] : sorted) printRow(name, entry);
+  }
+  G4cout << std::setprecision(6);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfile::Write(const G4String &fileName) const {
+  std::ofstream file(fileName);
+  file << "particle,volume,creator,tracks,steps,time_s\n";
+  for (const auto &[names, entry] : GetNamedEntries()) {
+    file << names[0] << "," << names[1] << "," << names[2] << ","
+         << entry.nofTracks << "," << entry.nofSteps << "," << entry.time
+         << "\n";
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
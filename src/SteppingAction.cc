@@ -0,0 +1,275 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/SteppingAction.cc
+/// \brief Implementation of the B4d::SteppingAction class
+
+#include "SteppingAction.hh"
+#include "DetectorConstruction.hh"
+#include "PhaseSpace.hh"
+#include "Run.hh"
+
+#include "G4DynamicParticle.hh"
+#include "G4LogicalVolume.hh"
+#include "G4NavigationHistory.hh"
+#include "G4Neutron.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4SteppingManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4VSolid.hh"
+#include "G4Track.hh"
+#include "G4VTouchable.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SteppingAction::SteppingAction(
+    const PhaseSpaceParameters *phaseSpaceParameters,
+    const KillParameters *killParameters,
+    const BiasingParameters *biasingParameters,
+    const ProfileParameters *profileParameters)
+    : fPhaseSpaceParameters(phaseSpaceParameters),
+      fKillParameters(killParameters), fBiasingParameters(biasingParameters),
+      fProfileParameters(profileParameters),
+      fDetector(static_cast<const DetectorConstruction *>(
+          G4RunManager::GetRunManager()->GetUserDetectorConstruction())),
+      fNeutron(G4Neutron::Definition()) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SteppingAction::IsTarget(const G4LogicalVolume *volume) {
+  // the geometry may be rebuilt between runs: check the name if the volume
+  // differs from the cached one
+  if (volume == fTargetLV) return true;
+  if (volume->GetName() != "Target") return false;
+  fTargetLV = volume;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::UserSteppingAction(const G4Step *step) {
+  auto run = static_cast<Run *>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  run->AddStep();
+  if (fProfileParameters->enabled) run->ProfileStep(step);
+  if (step->GetTrack()->GetDefinition() == fNeutron) ProcessTargetExit(step);
+  ApplyKillZone(step);}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::ProcessTargetExit(const G4Step *step) {
+  // neutron leaving the target
+  auto postStepPoint = step->GetPostStepPoint();
+  if (postStepPoint->GetStepStatus() != fGeomBoundary) return;
+  auto preStepPoint = step->GetPreStepPoint();
+  if (!IsTarget(preStepPoint->GetPhysicalVolume()->GetLogicalVolume())) {
+    return;
+  }
+
+  const auto &position = postStepPoint->GetPosition();
+
+  // Lambertian approximation of the ring counts, which needs the outward
+  // normal of the Target surface at the exit point
+  const auto &transform =
+      preStepPoint->GetTouchable()->GetHistory()->GetTopTransform();
+  auto localNormal = fTargetLV->GetSolid()->SurfaceNormal(
+      transform.TransformPoint(position));
+  auto normal = transform.Inverse().TransformAxis(localNormal);
+  auto run = static_cast<Run *>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  run->ScoreLambertian(position, normal, postStepPoint->GetWeight());
+
+  // stage 1: write the neutron to the phase space file
+  auto writer = PhaseSpaceWriter::Instance();
+  if (writer->IsOpen()) {
+    const auto &direction = postStepPoint->GetMomentumDirection();
+    PhaseSpaceRecord record;
+    record.x = position.x() / mm;
+    record.y = position.y() / mm;
+    record.z = position.z() / mm;
+    record.dx = direction.x();
+    record.dy = direction.y();
+    record.dz = direction.z();
+    record.kinEnergy = postStepPoint->GetKineticEnergy() / MeV;
+    record.time = postStepPoint->GetGlobalTime() / ns;
+    record.weight = postStepPoint->GetWeight();
+    writer->Fill(record);
+
+    if (fPhaseSpaceParameters->killRecorded) {
+      step->GetTrack()->SetTrackStatus(fStopAndKill);
+    }
+  }
+
+  if (fBiasingParameters->enabled) ApplyBiasing(step);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double SteppingAction::GetTargetWeight(const G4Track *track) const {
+  // inverse of the importance of the neutron direction, for a unit source
+  // weight
+  const auto &direction = track->GetMomentumDirection();
+  if (std::abs(direction.y()) <= std::sin(fBiasingParameters->ringHalfAngle)) {
+    return 1. / fBiasingParameters->splitting;
+  }
+  return 1.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::ApplyBiasing(const G4Step *step) {
+  // the neutrons get their direction at their collisions in the Target: the
+  // split copies sample their next flights and collisions independently
+  auto postStepPoint = step->GetPostStepPoint();
+  if (postStepPoint->GetStepStatus() == fGeomBoundary) return;
+  if (!IsTarget(step->GetPreStepPoint()->GetPhysicalVolume()
+                    ->GetLogicalVolume())) {
+    return;
+  }
+
+  // the neutrons created in the step, the last secondaries; they are only
+  // split, their roulette is left to their first collision
+  auto secondaries = fpSteppingManager->GetfSecondary();
+  auto end = secondaries->size();
+  auto begin = end - step->GetSecondaryInCurrentStep()->size();
+  for (auto i = begin; i < end; ++i) {
+    auto secondary = (*secondaries)[i];
+    if (secondary->GetDefinition() != fNeutron) continue;
+    auto ratio = secondary->GetWeight() / GetTargetWeight(secondary);
+    if (ratio >= 2.) {
+      Split(secondary, G4int(ratio + 0.5), secondary->GetParentID(),
+            secondary->GetTouchableHandle());
+    }
+  }
+
+  // the neutron after its collision; the weight is set in the post-step
+  // point too, which becomes the pre-step point seen by the scorers at the
+  // next step
+  auto track = step->GetTrack();
+  if (track->GetDefinition() != fNeutron || track->GetTrackStatus() != fAlive) {
+    return;
+  }
+  auto targetWeight = GetTargetWeight(track);
+  auto ratio = track->GetWeight() / targetWeight;
+  if (ratio >= 2.) {
+    Split(track, G4int(ratio + 0.5), track->GetTrackID(),
+          postStepPoint->GetTouchableHandle());
+    postStepPoint->SetWeight(track->GetWeight());
+  } else if (ratio < 0.5) {
+    // roulette up to the target weight
+    auto survived = G4UniformRand() < ratio;
+    if (survived) {
+      track->SetWeight(targetWeight);
+      postStepPoint->SetWeight(targetWeight);
+    } else {
+      track->SetTrackStatus(fStopAndKill);
+    }
+    auto run = static_cast<Run *>(
+        G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    run->AddRouletteTrack(survived);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::Split(G4Track *track, G4int n, G4int parentID,
+                           const G4TouchableHandle &touchable) {
+  // the copies are the same particle at the same point: they keep its
+  // creator, for the origin tagging and the step profile
+  auto weight = track->GetWeight() / n;
+  track->SetWeight(weight);
+  auto secondaries = fpSteppingManager->GetfSecondary();
+  for (G4int i = 1; i < n; ++i) {
+    auto copy =
+        new G4Track(new G4DynamicParticle(*track->GetDynamicParticle()),
+                    track->GetGlobalTime(), track->GetPosition());
+    copy->SetWeight(weight);
+    copy->SetParentID(parentID);
+    copy->SetTouchableHandle(touchable);
+    copy->SetCreatorProcess(track->GetCreatorProcess());
+    copy->SetCreatorModelID(track->GetCreatorModelID());
+    secondaries->push_back(copy);
+  }
+  auto run = static_cast<Run *>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  run->AddSplitTracks(n - 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::ApplyKillZone(const G4Step *step) {
+  auto track = step->GetTrack();
+  if (track->GetTrackStatus() != fAlive) return;
+
+  auto postStepPoint = step->GetPostStepPoint();
+  auto reason = Run::kNofKillReasons;
+
+  if (fKillParameters->outsideEnvelope) {
+    // a track leaving the shell is on its outer surface, within tolerance
+    const auto &position = postStepPoint->GetPosition();
+    auto distance = std::max({std::abs(position.x()), std::abs(position.y()),
+                              std::abs(position.z())});
+    auto envelope = fDetector->GetShellHalfLength();
+    if (distance > envelope ||
+        (postStepPoint->GetStepStatus() == fGeomBoundary &&
+         distance > envelope - 1. * micrometer)) {
+      reason = Run::kOutsideEnvelope;
+    }
+  }
+
+  auto timeCut = fKillParameters->timeCut;
+  if (reason == Run::kNofKillReasons && timeCut > 0. &&
+      postStepPoint->GetGlobalTime() > timeCut) {
+    reason = Run::kTimeCut;
+  }
+
+  auto kinEnergy = postStepPoint->GetKineticEnergy();
+  auto energyCut = (track->GetDefinition() == fNeutron)
+                       ? fKillParameters->neutronEnergyCut
+                       : fKillParameters->energyCut;
+  if (reason == Run::kNofKillReasons && kinEnergy < energyCut) {
+    reason = Run::kEnergyCut;
+  }
+
+  if (reason == Run::kNofKillReasons) return;
+
+  track->SetTrackStatus(fStopAndKill);
+  auto run = static_cast<Run *>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  run->AddZoneKilledTrack(Run::GetSpecies(track->GetDefinition()), reason,
+                          kinEnergy);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,84 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file B4/B4d/src/TargetParallelWorld.cc
+/// \brief Implementation of the B4d::TargetParallelWorld class
+
+#include "TargetParallelWorld.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4SDManager.hh"
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TargetParallelWorld::TargetParallelWorld(const G4String &worldName,
+                                         const DetectorConstruction *detector)
+    : G4VUserParallelWorld(worldName), fDetector(detector) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TargetParallelWorld::Construct() {
+  // called after the mass geometry is (re)built
+  fTargetDetLV = nullptr;
+  if (fDetector->GetTargetScoring() != "parallel") return;
+
+  // the scoring volume follows the Target of the mass geometry
+  auto targetPV =
+      G4PhysicalVolumeStore::GetInstance()->GetVolume("Target", false);
+  if (!targetPV) return;
+
+  fTargetDetLV = new G4LogicalVolume(targetPV->GetLogicalVolume()->GetSolid(),
+                                     nullptr, // no material
+                                     "TargetDetLV");
+
+  new G4PVPlacement(targetPV->GetRotation(),        // its rotation
+                    targetPV->GetTranslation(),     // its position
+                    fTargetDetLV,                   // its logical volume
+                    "TargetDet",                    // its name
+                    GetWorld()->GetLogicalVolume(), // its mother volume
+                    false,                          // no boolean operation
+                    0,                              // copy number
+                    fDetector->GetCheckOverlaps()); // checking overlaps
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TargetParallelWorld::ConstructSD() {
+  // the sensitive detector is created with the others in DetectorConstruction
+  if (!fTargetDetLV) return;
+  SetSensitiveDetector(
+      fTargetDetLV,
+      G4SDManager::GetSDMpointer()->FindSensitiveDetector("TargetDet"));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
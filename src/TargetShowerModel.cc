@@ -0,0 +1,134 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/TargetShowerModel.cc
+/// \brief Implementation of the B4d::TargetShowerModel class
+
+#include "TargetShowerModel.hh"
+#include "Run.hh"
+
+#include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
+#include "G4FastStep.hh"
+#include "G4FastTrack.hh"
+#include "G4Gamma.hh"
+#include "G4IonisParamMat.hh"
+#include "G4Material.hh"
+#include "G4Neutron.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4Poisson.hh"
+#include "G4Positron.hh"
+#include "G4RandomDirection.hh"
+#include "G4RunManager.hh"
+#include "G4Track.hh"
+#include "G4VSolid.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TargetShowerModel::TargetShowerModel(const G4String &name, G4Region *region,
+                                     const FastShowerParameters *parameters)
+    : G4VFastSimulationModel(name, region), fParameters(parameters),
+      fNeutron(G4Neutron::Definition()) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TargetShowerModel::IsApplicable(const G4ParticleDefinition &particle) {
+  return &particle == G4Electron::Definition() ||
+         &particle == G4Positron::Definition() ||
+         &particle == G4Gamma::Definition();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TargetShowerModel::ModelTrigger(const G4FastTrack &fastTrack) {
+  return fParameters->enabled &&
+         fastTrack.GetPrimaryTrack()->GetKineticEnergy() >
+             fParameters->energyThreshold;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double
+TargetShowerModel::GetShowerMaxDepth(const G4FastTrack &fastTrack) const {
+  // Rossi approximation B, with the critical energy 610 MeV / (Z + 1.24)
+  auto track = fastTrack.GetPrimaryTrack();
+  auto material = track->GetMaterial();
+  auto criticalEnergy =
+      610. * MeV / (material->GetIonisation()->GetZeffective() + 1.24);
+  auto constant = (track->GetDefinition() == G4Gamma::Definition()) ? 0.5
+                                                                    : -0.5;
+  auto depth =
+      material->GetRadlen() *
+      (std::log(track->GetKineticEnergy() / criticalEnergy) + constant);
+  return std::max(depth, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TargetShowerModel::DoIt(const G4FastTrack &fastTrack,
+                             G4FastStep &fastStep) {
+  auto track = fastTrack.GetPrimaryTrack();
+  auto energy = track->GetKineticEnergy();
+
+  // the whole shower is absorbed in the Target
+  fastStep.KillPrimaryTrack();
+  fastStep.ProposePrimaryTrackPathLength(0.);
+  fastStep.ProposeTotalEnergyDeposited(energy);
+
+  // the neutrons start at the shower maximum, in the envelope frame
+  auto position = fastTrack.GetPrimaryTrackLocalPosition();
+  auto direction = fastTrack.GetPrimaryTrackLocalDirection();
+  auto envelope = fastTrack.GetEnvelopeSolid();
+  auto depth = std::min(GetShowerMaxDepth(fastTrack),
+                        envelope->DistanceToOut(position, direction));
+  position += depth * direction;
+  auto time = track->GetGlobalTime() + depth / c_light;
+
+  auto nofNeutrons = G4int(G4Poisson(fParameters->neutronYield * energy / GeV));
+  fastStep.SetNumberOfSecondaryTracks(nofNeutrons);
+  for (G4int i = 0; i < nofNeutrons; ++i) {
+    // evaporation spectrum E exp(-E/T): sum of two exponential variates
+    auto kinEnergy =
+        -fParameters->temperature * std::log(G4UniformRand() * G4UniformRand());
+    G4DynamicParticle neutron(fNeutron, G4RandomDirection(), kinEnergy);
+    fastStep.CreateSecondaryTrack(neutron, position, time);
+  }
+
+  auto run = static_cast<Run *>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  run->AddFastShower(energy, nofNeutrons);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,79 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/TrackingAction.cc
+/// \brief Implementation of the B4d::TrackingAction class
+
+#include "TrackingAction.hh"
+#include "Run.hh"
+#include "SteppingAction.hh"
+#include "TrackInformation.hh"
+
+#include "G4RunManager.hh"
+#include "G4Track.hh"
+#include "G4TrackingManager.hh"
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TrackingAction::TrackingAction(const ProfileParameters *profileParameters)
+    : fProfileParameters(profileParameters) {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrackingAction::PreUserTrackingAction(const G4Track *track) {
+  if (fProfileParameters->enabled) {
+    static_cast<Run *>(G4RunManager::GetRunManager()->GetNonConstCurrentRun())
+        ->StartTrackProfile();
+  }
+
+  if (track->GetParentID() != 0 || track->GetUserInformation()) return;
+
+  track->SetUserInformation(new TrackInformation(
+      Run::GetSpecies(track->GetDefinition()), track->GetTrackID()));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrackingAction::PostUserTrackingAction(const G4Track *track) {
+  auto info = static_cast<const TrackInformation *>(
+      track->GetUserInformation());
+  if (!info) return;
+
+  auto secondaries = fpTrackingManager->GimmeSecondaries();
+  if (!secondaries) return;
+  for (auto secondary : *secondaries) {
+    if (!secondary->GetUserInformation()) {
+      secondary->SetUserInformation(new TrackInformation(*info));
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
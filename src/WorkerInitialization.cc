@@ -0,0 +1,172 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/WorkerInitialization.cc
+/// \brief Implementation of the B4d::WorkerInitialization class
+
+#include "WorkerInitialization.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+
+// cores of the process affinity mask
+std::vector<G4int> GetAvailableCores() {
+  std::vector<G4int> cores;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) return cores;
+  for (G4int core = 0; core < CPU_SETSIZE; ++core) {
+    if (CPU_ISSET(core, &set)) cores.push_back(core);
+  }
+  return cores;
+}
+
+// cores of a NUMA node, from its cpulist, eg. "0-15,32-47"
+std::vector<G4int> GetNodeCores(G4int node) {
+  std::vector<G4int> cores;
+  std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) +
+                     "/cpulist");
+  std::string range;
+  while (std::getline(file, range, ',')) {
+    G4int first = 0;
+    G4int last = 0;
+    char dash = 0;
+    std::istringstream is(range);
+    is >> first;
+    if (!(is >> dash >> last)) last = first;
+    for (G4int core = first; core <= last; ++core) cores.push_back(core);
+  }
+  return cores;
+}
+
+G4bool Pin(const std::vector<G4int> &cores) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto core : cores) CPU_SET(core, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+#else
+
+std::vector<G4int> GetAvailableCores() { return {}; }
+std::vector<G4int> GetNodeCores(G4int) { return {}; }
+G4bool Pin(const std::vector<G4int> &) { return false; }
+
+#endif
+
+} // namespace
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WorkerInitialization::WorkerInitialization() {
+  fCores = GetAvailableCores();
+
+  // the nodes are numbered from 0; a node without available core is left
+  // out
+  for (G4int node = 0;; ++node) {
+    auto nodeCores = GetNodeCores(node);
+    if (nodeCores.empty()) break;
+    std::vector<G4int> cores;
+    for (auto core : nodeCores) {
+      if (std::find(fCores.begin(), fCores.end(), core) != fCores.end()) {
+        cores.push_back(core);
+      }
+    }
+    if (!cores.empty()) fNodes.push_back(cores);
+  }
+
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WorkerInitialization::~WorkerInitialization() { delete fMessenger; }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WorkerInitialization::WorkerInitialize() const {
+  if (fPinning == "none") return;
+
+  auto threadId = G4Threading::G4GetThreadId();
+  std::vector<G4int> cores;
+  std::ostringstream target;
+  if (fPinning == "core" && !fCores.empty()) {
+    auto core = fCores[threadId % fCores.size()];
+    cores.push_back(core);
+    target << "core " << core;
+  } else if (fPinning == "numa" && !fNodes.empty()) {
+    auto node = threadId % fNodes.size();
+    cores = fNodes[node];
+    target << "NUMA node " << node << " (" << cores.size() << " cores)";
+  }
+
+  if (cores.empty() || !Pin(cores)) {
+    G4ExceptionDescription msg;
+    msg << "Worker " << threadId << " cannot be pinned (" << fPinning
+        << "), it runs on any core.";
+    G4Exception("WorkerInitialization::WorkerInitialize()", "MyCode0013",
+                JustWarning, msg);
+    return;
+  }
+  G4cout << " Worker " << threadId << " pinned to " << target.str()
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WorkerInitialization::DefineCommands() {
+  fMessenger = new G4GenericMessenger(this, "/B4/run/", "Run control");
+
+  auto &pinningCmd = fMessenger->DeclareProperty(
+      "pinning", fPinning,
+      "Pin each worker thread to one core (core), to the cores of one NUMA\n"
+      "node (numa), or not (none). It applies to the threads started\n"
+      "afterwards.");
+  pinningCmd.SetParameterName("pinning", false);
+  pinningCmd.SetCandidates("none core numa");
+  pinningCmd.SetStates(G4State_PreInit);
+  pinningCmd.SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d
@@ -0,0 +1,125 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+//
+/// \file B4/B4d/src/WorkerTimeline.cc
+/// \brief Implementation of the B4d::WorkerTimeline class
+
+#include "WorkerTimeline.hh"
+
+#include "G4AutoLock.hh"
+
+#include <algorithm>
+#include <fstream>
+
+namespace B4d {
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WorkerTimeline *WorkerTimeline::Instance() {
+  static WorkerTimeline instance;
+  return &instance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WorkerTimeline::Start(G4int nofThreads) {
+  G4AutoLock lock(&fMutex);
+  fStartTime = std::chrono::steady_clock::now();
+  fIntervals.assign(std::max(1, nofThreads), {});
+  fBusyTimes.assign(fIntervals.size(), 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WorkerTimeline::GetTime() const {
+  std::chrono::duration<G4double> time =
+      std::chrono::steady_clock::now() - fStartTime;
+  return time.count();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WorkerTimeline::AddEvent(G4double startTime) {
+  // the master has the thread id -1 in sequential mode
+  auto thread = std::size_t(std::max(0, G4Threading::G4GetThreadId()));
+  auto endTime = GetTime();
+
+  G4AutoLock lock(&fMutex);
+  if (thread >= fIntervals.size()) {
+    fIntervals.resize(thread + 1);
+    fBusyTimes.resize(thread + 1, 0.);
+  }
+  fIntervals[thread].push_back({startTime, endTime});
+  fBusyTimes[thread] += endTime - startTime;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4double> WorkerTimeline::GetMeanEventTimes() const {
+  G4AutoLock lock(&fMutex);
+  std::vector<G4double> meanTimes(fIntervals.size(), 0.);
+  for (std::size_t i = 0; i < fIntervals.size(); ++i) {
+    if (!fIntervals[i].empty()) {
+      meanTimes[i] = fBusyTimes[i] / fIntervals[i].size();
+    }
+  }
+  return meanTimes;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WorkerTimeline::Write(const G4String &fileName) {
+  G4AutoLock lock(&fMutex);
+  auto runTime = GetTime();
+  if (runTime <= 0. || fIntervals.empty()) return;
+
+  std::ofstream file(fileName);
+  file << "thread,start,end\n";
+  G4double busyTime = 0.;
+  G4double tailTime = 0.;
+  G4double maxTailTime = 0.;
+  for (std::size_t i = 0; i < fIntervals.size(); ++i) {
+    for (const auto &interval : fIntervals[i]) {
+      file << i << "," << interval.start << "," << interval.end << "\n";
+    }
+    auto lastEnd = fIntervals[i].empty() ? 0. : fIntervals[i].back().end;
+    busyTime += fBusyTimes[i];
+    tailTime += runTime - lastEnd;
+    maxTailTime = std::max(maxTailTime, runTime - lastEnd);
+  }
+
+  auto totalTime = runTime * fIntervals.size();
+  G4cout << " Threads: " << fIntervals.size() << ", idle "
+         << 100. * (1. - busyTime / totalTime) << " % of the run, "
+         << 100. * tailTime / totalTime << " % in the tail (longest "
+         << maxTailTime << " s); timeline written in " << fileName
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+} // namespace B4d